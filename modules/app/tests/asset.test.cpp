@@ -0,0 +1,16 @@
+#include <catch2/catch_test_macros.hpp>
+
+import triple.app;
+import triple.ecs;
+
+using namespace triple;
+
+TEST_CASE("Asset server", "[app]") {
+    ecs::World world;
+    // loaders make graphics calls, so systems loading assets never run on
+    // worker threads
+    auto& loader = world.system(+[](ecs::Resource<app::AssetServer>) {});
+    REQUIRE(loader.main_thread());
+    auto& reader = world.system(+[](ecs::Resource<const app::AssetServer>) {});
+    REQUIRE(reader.main_thread());
+}
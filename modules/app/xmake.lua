@@ -2,3 +2,9 @@ target("triple_app")
     set_kind("moduleonly")
     add_files("*.mpp")
     add_deps("triple_base", "triple_math", "triple_refl", "triple_ecs")
+
+target("triple_app-tests")
+    set_kind("binary")
+    add_files("tests/*.test.cpp")
+    add_packages("catch2")
+    add_deps("triple_app")
@@ -0,0 +1,66 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+import triple.base;
+
+using namespace triple;
+
+TEST_CASE("Thread pool", "[thread_pool]") {
+    ThreadPool pool(4);
+    REQUIRE(pool.thread_count() == 4);
+
+    SECTION("Parallel for") {
+        std::vector<std::atomic<int>> hits(1000);
+        pool.parallel_for(
+            3,
+            1000,
+            64,
+            [&](std::size_t first, std::size_t last) {
+                for (std::size_t i = first; i < last; i++) {
+                    hits[i]++;
+                }
+            }
+        );
+        for (std::size_t i = 0; i < hits.size(); i++) {
+            REQUIRE(hits[i] == (i >= 3 ? 1 : 0));
+        }
+    }
+
+    SECTION("Nested task groups") {
+        // tasks waiting on their own subtasks must not starve the pool
+        std::function<long long(int)> fib = [&](int n) -> long long {
+            if (n < 12) {
+                return n < 2 ? n : fib(n - 1) + fib(n - 2);
+            }
+            long long a = 0;
+            long long b = 0;
+            TaskGroup group(pool);
+            group.run([&] { a = fib(n - 1); });
+            group.run([&] { b = fib(n - 2); });
+            group.wait();
+            return a + b;
+        };
+        REQUIRE(fib(24) == 46368);
+    }
+
+    SECTION("Waiting thread runs tasks") {
+        ThreadPool inline_pool(1);
+        std::thread::id caller = std::this_thread::get_id();
+        std::atomic<int> count = 0;
+        {
+            TaskGroup group(inline_pool);
+            for (int i = 0; i < 10; i++) {
+                group.run([&] {
+                    REQUIRE(std::this_thread::get_id() == caller);
+                    count++;
+                });
+            }
+            REQUIRE(count == 0);
+        }
+        REQUIRE(count == 10);
+    }
+}
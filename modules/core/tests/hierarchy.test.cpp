@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstddef>
+#include <numbers>
+#include <vector>
+
+import triple.app;
+import triple.base;
+import triple.core;
+import triple.ecs;
+import triple.math;
+
+using namespace triple;
+
+TEST_CASE("Transform propagation", "[core][hierarchy]") {
+    app::App app;
+    app.add_plugin<core::TransformPlugin>();
+    ecs::World& world = app.world();
+
+    ecs::Entity ship = world.spawn(core::Transform2D {.position = {10, 0}});
+    ecs::Entity turret = world.spawn(core::Transform2D {.position = {1, 0}});
+    ecs::Entity barrel = world.spawn(core::Transform2D {.position = {0, 2}});
+    ecs::Entity rock = world.spawn(core::Transform2D {.position = {-5, -5}});
+    core::set_parent(world, turret, ship);
+    core::set_parent(world, barrel, turret);
+
+    auto position = [&](ecs::Entity entity) {
+        return world.get_component<core::GlobalTransform2D>(entity)
+            .affine.translation();
+    };
+    auto near = [](math::Vector2 a, math::Vector2 b) {
+        return std::abs(a.x - b.x) < 1e-4f && std::abs(a.y - b.y) < 1e-4f;
+    };
+    // runs the propagation, returns how many global transforms it wrote
+    auto update = [&] {
+        ecs::Tick tick = world.increment_change_tick();
+        app.run_schedule(app::PostUpdate);
+        std::size_t written = 0;
+        for (auto [entity] :
+             world.query<ecs::Entity, ecs::Changed<core::GlobalTransform2D>>(
+                 tick
+             )) {
+            written++;
+        }
+        return written;
+    };
+
+    REQUIRE(update() == 4);
+    REQUIRE(near(position(ship), {10, 0}));
+    REQUIRE(near(position(turret), {11, 0}));
+    REQUIRE(near(position(barrel), {11, 2}));
+    REQUIRE(near(position(rock), {-5, -5}));
+    REQUIRE(update() == 0);
+
+    // only the dirty subtree is recomputed
+    world.add_component(
+        ship,
+        core::Transform2D {
+            .position = {10, 0},
+            .rotation = std::numbers::pi_v<float> / 2
+        }
+    );
+    REQUIRE(update() == 3);
+    REQUIRE(near(position(turret), {10, 1}));
+    REQUIRE(near(position(barrel), {8, 1}));
+
+    world.add_component(barrel, core::Transform2D {.position = {0, 3}});
+    REQUIRE(update() == 1);
+    REQUIRE(near(position(barrel), {7, 1}));
+
+    SECTION("reparenting") {
+        core::set_parent(world, turret, rock);
+        REQUIRE(update() == 2);
+        REQUIRE(near(position(barrel), {-4, -2}));
+        REQUIRE(world.get_component<core::Children>(ship).entities.empty());
+
+        core::remove_parent(world, turret);
+        REQUIRE(update() == 2);
+        REQUIRE(near(position(turret), {1, 0}));
+        REQUIRE(near(position(barrel), {1, 3}));
+        REQUIRE_FALSE(world.has_component<core::Parent>(turret));
+
+        // cycles are refused
+        core::set_parent(world, turret, barrel);
+        REQUIRE_FALSE(world.has_component<core::Parent>(turret));
+    }
+
+    SECTION("despawning a subtree") {
+        core::despawn_recursive(world, turret);
+        REQUIRE(world.has_entity(ship));
+        REQUIRE_FALSE(world.has_entity(turret));
+        REQUIRE_FALSE(world.has_entity(barrel));
+        REQUIRE(world.get_component<core::Children>(ship).entities.empty());
+    }
+
+    SECTION("many roots") {
+        // large enough to be split up on the world's pool
+        ThreadPool pool(3);
+        world.set_thread_pool(&pool);
+        std::vector<ecs::Entity> roots;
+        std::vector<ecs::Entity> leaves;
+        for (int i = 0; i < 200; i++) {
+            ecs::Entity root = world.spawn(
+                core::Transform2D {.position = {float(i), 0}}
+            );
+            for (int j = 0; j < 10; j++) {
+                ecs::Entity leaf = world.spawn(
+                    core::Transform2D {.position = {0, float(j)}}
+                );
+                core::set_parent(world, leaf, root);
+                leaves.push_back(leaf);
+            }
+            roots.push_back(root);
+        }
+        REQUIRE(update() == 2200);
+        for (std::size_t i = 0; i < leaves.size(); i++) {
+            REQUIRE(near(
+                position(leaves[i]),
+                {float(i / 10), float(i % 10)}
+            ));
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+
+import triple.core;
+import triple.math;
+
+using namespace triple;
+
+TEST_CASE("Affine transforms", "[core][transform]") {
+    core::Transform2D transform {
+        .position = {3, -2},
+        .scale = {2, 0.5f},
+        .rotation = 0.7f,
+    };
+    math::Affine2D affine = transform.affine();
+    math::Matrix4x4 expected = math::translate(3, -2, 0) *
+                               math::rotate_z(0.7f) * math::scale(2, 0.5f, 1);
+    math::Matrix4x4 matrix = affine.to_matrix4x4();
+    for (int row = 0; row < 4; row++) {
+        for (int col = 0; col < 4; col++) {
+            REQUIRE(std::abs(matrix[row][col] - expected[row][col]) < 1e-5f);
+        }
+    }
+
+    math::Vector2 point {1.5f, 4};
+    math::Vector4 moved = expected * math::Vector4 {point.x, point.y, 0, 1};
+    math::Vector2 transformed = affine.transform_point(point);
+    REQUIRE(std::abs(transformed.x - moved.x) < 1e-5f);
+    REQUIRE(std::abs(transformed.y - moved.y) < 1e-5f);
+
+    // composing with the inverse gives the identity back
+    math::Affine2D identity = affine * affine.inversed();
+    for (int row = 0; row < 2; row++) {
+        for (int col = 0; col < 3; col++) {
+            float value = math::Affine2D::Identity[row][col];
+            REQUIRE(std::abs(identity[row][col] - value) < 1e-5f);
+        }
+    }
+    REQUIRE(math::Affine2D::scale(0, 1).inversed() == math::Affine2D::Zero);
+
+    // composition applies the right-hand side first
+    math::Affine2D moved_then_scaled =
+        math::Affine2D::scale(2, 2) * math::Affine2D::translate(1, 0);
+    REQUIRE(moved_then_scaled.translation() == math::Vector2 {2, 0});
+}
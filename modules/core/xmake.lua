@@ -7,3 +7,9 @@ target("triple_core")
         "triple_ecs",
         "triple_math"
     )
+
+target("triple_core-tests")
+    set_kind("binary")
+    add_files("tests/*.test.cpp")
+    add_packages("catch2")
+    add_deps("triple_core")
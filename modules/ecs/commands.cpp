@@ -1,43 +1,52 @@
+module;
+#include <utility>
+
 module triple.ecs;
 import triple.refl;
 
 namespace triple::ecs {
 
-Commands::Commands(World& world) : m_world(world) {}
+Commands::Commands(World& world) :
+    m_world(world), m_buffer(world.command_buffer()) {}
+
+Commands::Commands(World& world, CommandBuffer& buffer) :
+    m_world(world), m_buffer(buffer) {}
 
 EntityCommands Commands::spawn() {
-    return {m_world, m_world.entity()};
+    return {m_world, m_buffer, m_world.reserve_entity()};
 }
 
 EntityCommands Commands::entity(Entity id) {
-    return {m_world, id};
+    return {m_world, m_buffer, id};
 }
 
-EntityCommands::EntityCommands(World& world, Entity entity) :
-    m_world(world), m_entity(entity) {}
+EntityCommands::EntityCommands(
+    World& world,
+    CommandBuffer& buffer,
+    Entity entity
+) :
+    m_world(world), m_buffer(buffer), m_entity(entity) {}
 
 EntityCommands& EntityCommands::add(refl::Value component) {
-    m_world.add_command([entity = m_entity, component](World& world) {
-        world.add_component(entity, component.ref());
-    });
+    m_buffer.insert(m_entity, component.ref());
     return *this;
 }
 
 EntityCommands& EntityCommands::remove(const refl::Type& component_type) {
-    m_world.add_command([entity = m_entity, &component_type](World& world) {
-        world.remove_component(entity, component_type);
-    });
+    m_buffer.remove(m_entity, component_type);
     return *this;
 }
 
 bool EntityCommands::has_component(const refl::Type& component_type) {
+    // spawned entities are only placed once the commands are applied
+    if (!m_world.has_entity(m_entity)) {
+        return false;
+    }
     return m_world.has_component(m_entity, component_type);
 }
 
 void EntityCommands::despawn() {
-    m_world.add_command([entity = m_entity](World& world) {
-        world.despawn(entity);
-    });
+    m_buffer.despawn(m_entity);
 }
 
 Entity EntityCommands::id() {
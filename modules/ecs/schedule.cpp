@@ -0,0 +1,213 @@
+module;
+#include <condition_variable>
+#include <algorithm>
+#include <cstddef>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+module triple.ecs;
+import triple.base;
+
+namespace triple::ecs {
+
+void Schedule::build_graph() {
+    std::size_t count = m_nodes.size();
+    // edges from SystemOrder, matched by label
+    std::vector<std::vector<std::size_t>> successors(count);
+    std::vector<std::size_t> predecessors(count, 0);
+    auto add_edge = [&](std::size_t from, std::size_t to) {
+        if (from != to && std::ranges::find(successors[from], to) ==
+                              successors[from].end()) {
+            successors[from].push_back(to);
+            predecessors[to]++;
+        }
+    };
+    for (std::size_t i = 0; i < count; i++) {
+        const SystemOrder& order = m_nodes[i].m_system->order();
+        for (std::size_t j = 0; j < count; j++) {
+            const std::string& label = m_nodes[j].m_system->order().label;
+            if (label.empty()) {
+                continue;
+            }
+            if (std::ranges::find(order.before, label) != order.before.end()) {
+                add_edge(i, j);
+            }
+            if (std::ranges::find(order.after, label) != order.after.end()) {
+                add_edge(j, i);
+            }
+        }
+    }
+
+    // Topological sort taking the earliest added system first. A system
+    // lands in the stage of its latest predecessor, or the one after if that
+    // predecessor's commands have to be applied first.
+    for (Node& node : m_nodes) {
+        node.m_stage = node.m_sync_point;
+    }
+    std::set<std::size_t> ready;
+    for (std::size_t i = 0; i < count; i++) {
+        if (predecessors[i] == 0) {
+            ready.insert(i);
+        }
+    }
+    std::vector<std::size_t> sorted;
+    while (!ready.empty()) {
+        std::size_t i = *ready.begin();
+        ready.erase(ready.begin());
+        sorted.push_back(i);
+        std::size_t stage =
+            m_nodes[i].m_stage + (m_nodes[i].m_system->has_deferred() ? 1 : 0);
+        for (std::size_t j : successors[i]) {
+            m_nodes[j].m_stage = std::max(m_nodes[j].m_stage, stage);
+            if (--predecessors[j] == 0) {
+                ready.insert(j);
+            }
+        }
+    }
+    if (sorted.size() < count) {
+        log::error("Ordering cycle in schedule {}, ignoring it", m_id);
+        for (std::size_t i = 0; i < count; i++) {
+            if (predecessors[i] != 0) {
+                sorted.push_back(i);
+            }
+        }
+    }
+
+    // stages without systems are dropped
+    std::vector<std::size_t> stages;
+    for (Node& node : m_nodes) {
+        stages.push_back(node.m_stage);
+    }
+    std::ranges::sort(stages);
+    auto [last, _] = std::ranges::unique(stages);
+    stages.erase(last, stages.end());
+    m_stages.assign(stages.size(), {});
+    for (std::size_t i : sorted) {
+        Node& node = m_nodes[i];
+        node.m_stage = std::ranges::lower_bound(stages, node.m_stage) -
+                       stages.begin();
+        m_stages[node.m_stage].m_nodes.push_back(i);
+        m_stages[node.m_stage].m_systems.push_back(node.m_system);
+        node.m_dependents.clear();
+        node.m_dependency_count = 0;
+    }
+
+    // within a stage a system waits for the systems it's ordered after and
+    // for earlier ones it conflicts with
+    for (Stage& stage : m_stages) {
+        for (std::size_t a = 0; a < stage.m_nodes.size(); a++) {
+            std::size_t i = stage.m_nodes[a];
+            const SystemAccess& access = m_nodes[i].m_system->access();
+            for (std::size_t b = a + 1; b < stage.m_nodes.size(); b++) {
+                std::size_t j = stage.m_nodes[b];
+                if (std::ranges::find(successors[i], j) !=
+                        successors[i].end() ||
+                    access.conflicts_with(m_nodes[j].m_system->access())) {
+                    m_nodes[i].m_dependents.push_back(j);
+                    m_nodes[j].m_dependency_count++;
+                }
+            }
+        }
+    }
+    m_graph_dirty = false;
+}
+
+std::size_t Schedule::stage_count() {
+    if (m_graph_dirty) {
+        build_graph();
+    }
+    return m_stages.size();
+}
+
+const std::vector<System*>& Schedule::stage(std::size_t index) {
+    if (m_graph_dirty) {
+        build_graph();
+    }
+    return m_stages[index].m_systems;
+}
+
+std::vector<std::size_t> Schedule::dependencies(std::size_t index) {
+    if (m_graph_dirty) {
+        build_graph();
+    }
+    std::vector<std::size_t> dependencies;
+    for (std::size_t i = 0; i < m_nodes.size(); i++) {
+        if (std::ranges::find(m_nodes[i].m_dependents, index) !=
+            m_nodes[i].m_dependents.end()) {
+            dependencies.push_back(i);
+        }
+    }
+    return dependencies;
+}
+
+void Schedule::run_parallel(std::size_t stage, ThreadPool& pool) {
+    if (m_graph_dirty) {
+        build_graph();
+    }
+    const std::vector<std::size_t>& nodes = m_stages[stage].m_nodes;
+    // All bookkeeping happens on this thread, workers only report the
+    // systems they finished.
+    std::vector<std::size_t> waiting(m_nodes.size());
+    std::vector<std::size_t> main_ready;
+    std::vector<std::size_t> finished;
+    std::mutex mutex;
+    std::condition_variable condition;
+
+    auto start = [&](std::size_t index) {
+        System* system = m_nodes[index].m_system;
+        if (system->main_thread()) {
+            main_ready.push_back(index);
+            return;
+        }
+        pool.submit([&, system, index] {
+            system->run();
+            // notify under the lock, the state lives on the caller's stack
+            std::lock_guard lock(mutex);
+            finished.push_back(index);
+            condition.notify_one();
+        });
+    };
+
+    for (std::size_t i : nodes) {
+        waiting[i] = m_nodes[i].m_dependency_count;
+        if (waiting[i] == 0) {
+            start(i);
+        }
+    }
+
+    std::size_t done = 0;
+    std::vector<std::size_t> completed;
+    while (done < nodes.size()) {
+        if (!main_ready.empty()) {
+            std::size_t index = main_ready.front();
+            main_ready.erase(main_ready.begin());
+            m_nodes[index].m_system->run();
+            completed.push_back(index);
+        } else {
+            std::unique_lock lock(mutex);
+            if (finished.empty()) {
+                // help out rather than idle, a pool without workers needs it
+                lock.unlock();
+                if (pool.run_pending_task()) {
+                    continue;
+                }
+                lock.lock();
+                condition.wait(lock, [&] { return !finished.empty(); });
+            }
+            completed.swap(finished);
+        }
+        for (std::size_t index : completed) {
+            done++;
+            for (std::size_t dependent : m_nodes[index].m_dependents) {
+                if (--waiting[dependent] == 0) {
+                    start(dependent);
+                }
+            }
+        }
+        completed.clear();
+    }
+}
+
+} // namespace triple::ecs
@@ -0,0 +1,521 @@
+module;
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+module triple.ecs;
+import triple.base;
+import triple.refl;
+
+namespace triple::ecs {
+
+// Snapshot layout, integers in native byte order:
+//
+//   SnapshotHeader
+//   generation of every entity slot     u32 x slot count
+//   free slot indices                   u32 x free count
+//   per non-empty archetype:
+//     ArchetypeHeader
+//     ColumnHeader x component count, in column order
+//     entities                          Entity x row count
+//     per column either the raw bytes of all rows, or a u64 byte count
+//     followed by the rows encoded member by member
+//
+// Nothing is aligned, the loader reads through memcpy.
+
+constexpr char c_snapshot_magic[4] = {'T', 'R', 'S', 'N'};
+constexpr std::uint32_t c_snapshot_version = 1;
+
+struct SnapshotHeader {
+    char m_magic[4];
+    std::uint32_t m_version;
+    std::uint64_t m_slot_count;
+    std::uint64_t m_free_count;
+    std::uint64_t m_archetype_count;
+};
+
+struct ArchetypeHeader {
+    std::uint64_t m_component_count;
+    std::uint64_t m_row_count;
+};
+
+enum class ColumnEncoding : std::uint32_t {
+    Raw,
+    Reflected,
+};
+
+struct ColumnHeader {
+    refl::TypeId m_type;
+    std::uint32_t m_size;
+    ColumnEncoding m_encoding;
+};
+
+// Bounds-checked cursor over the mapped file.
+class SnapshotReader {
+  public:
+    SnapshotReader(std::span<const std::byte> bytes) : m_bytes(bytes) {}
+
+    // The next `count` elements of `size` bytes, or null if the file ends
+    // before them.
+    const std::byte* take(std::uint64_t count, std::size_t size = 1) {
+        std::size_t left = m_bytes.size() - m_offset;
+        if (size != 0 && count > left / size) {
+            return nullptr;
+        }
+        const std::byte* data = m_bytes.data() + m_offset;
+        m_offset += count * size;
+        return data;
+    }
+
+    bool read(void* dst, std::size_t size) {
+        const std::byte* data = take(size);
+        if (data != nullptr) {
+            std::memcpy(dst, data, size);
+        }
+        return data != nullptr;
+    }
+
+    template<class T>
+    bool read(T& value) {
+        return read(&value, sizeof(T));
+    }
+
+    template<class T>
+    bool read_array(std::vector<T>& values, std::uint64_t count) {
+        const std::byte* data = take(count, sizeof(T));
+        if (data == nullptr) {
+            return false;
+        }
+        values.resize(count);
+        if (count > 0) {
+            std::memcpy(values.data(), data, count * sizeof(T));
+        }
+        return true;
+    }
+
+  private:
+    std::span<const std::byte> m_bytes;
+    std::size_t m_offset = 0;
+};
+
+// Members of a class in name order, the order they are stored in.
+std::vector<const refl::Member*> sorted_members(const refl::Cls& cls) {
+    std::vector<const refl::Member*> members;
+    for (const auto& [_, member] : cls.members()) {
+        members.push_back(member);
+    }
+    std::ranges::sort(members, {}, &refl::Member::name);
+    return members;
+}
+
+bool is_encodable(const refl::Type& type) {
+    if (type.trivially_copyable() || type == refl::type<std::string>()) {
+        return true;
+    }
+    const refl::Cls* cls = refl::find_cls(type);
+    if (cls == nullptr || cls->members().empty()) {
+        return false;
+    }
+    return std::ranges::all_of(cls->members(), [](const auto& entry) {
+        return is_encodable(entry.second->type());
+    });
+}
+
+// Whether the reflected members of `object` cover all of it, so encoding it
+// member by member loses nothing. A gap wider than the alignment padding
+// before a member is a field that isn't reflected.
+bool is_fully_reflected(const refl::Type& type, const void* object) {
+    if (type.trivially_copyable() || type == refl::type<std::string>()) {
+        return true;
+    }
+    struct Field {
+        std::size_t m_offset;
+        const refl::Member* m_member;
+    };
+    refl::Ref ref(const_cast<void*>(object), type);
+    auto begin = reinterpret_cast<std::uintptr_t>(object);
+    std::vector<Field> fields;
+    for (const auto& [_, member] : refl::find_cls(type)->members()) {
+        auto address =
+            reinterpret_cast<std::uintptr_t>(member->get(ref).address());
+        // static members live outside the object
+        if (address >= begin && address < begin + type.size()) {
+            fields.push_back({address - begin, member});
+        }
+    }
+    std::ranges::sort(fields, {}, &Field::m_offset);
+    std::size_t end = 0;
+    for (const Field& field : fields) {
+        const refl::Type& member_type = field.m_member->type();
+        if (field.m_offset > align_up(end, member_type.align()) ||
+            !is_fully_reflected(
+                member_type,
+                field.m_member->get(ref).address()
+            )) {
+            return false;
+        }
+        end = field.m_offset + member_type.size();
+    }
+    return align_up(end, type.align()) == type.size();
+}
+
+void encode(
+    const refl::Type& type,
+    const void* object,
+    std::vector<std::byte>& out
+) {
+    auto append = [&](const void* data, std::size_t size) {
+        const auto* bytes = static_cast<const std::byte*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    };
+    if (type.trivially_copyable()) {
+        append(object, type.size());
+    } else if (type == refl::type<std::string>()) {
+        const auto& string = *static_cast<const std::string*>(object);
+        std::uint64_t size = string.size();
+        append(&size, sizeof(size));
+        append(string.data(), string.size());
+    } else {
+        refl::Ref ref(const_cast<void*>(object), type);
+        const refl::Cls& cls = *refl::find_cls(type);
+        for (const refl::Member* member : sorted_members(cls)) {
+            encode(member->type(), member->get(ref).address(), out);
+        }
+    }
+}
+
+// Reads an object written by `encode` into the live `object`.
+bool decode(const refl::Type& type, void* object, SnapshotReader& in) {
+    if (type.trivially_copyable()) {
+        return in.read(object, type.size());
+    }
+    if (type == refl::type<std::string>()) {
+        std::uint64_t size;
+        const std::byte* data = in.read(size) ? in.take(size) : nullptr;
+        if (data == nullptr) {
+            return false;
+        }
+        static_cast<std::string*>(object)->assign(
+            reinterpret_cast<const char*>(data),
+            size
+        );
+        return true;
+    }
+    refl::Ref ref(object, type);
+    const refl::Cls& cls = *refl::find_cls(type);
+    for (const refl::Member* member : sorted_members(cls)) {
+        if (!decode(member->type(), member->get(ref).address(), in)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool World::save_snapshot(const std::filesystem::path& path) {
+    flush_reserved_entities();
+    std::vector<Archetype*> archetypes;
+    for (Archetype* archetype : m_archetypes) {
+        if (archetype->size() == 0) {
+            continue;
+        }
+        for (const refl::Type* component : archetype->components()) {
+            if (!is_encodable(*component)) {
+                log::error(
+                    "Can't snapshot component {}, it is neither trivially "
+                    "copyable nor reflected",
+                    component->full_name()
+                );
+                return false;
+            }
+        }
+        // the layout is the same for every row, the first one tells
+        const std::vector<Column>& columns = archetype->columns();
+        for (std::size_t column = 0; column < columns.size(); column++) {
+            const refl::Type& type = *columns[column].m_type;
+            const void* first = archetype->get_component(column, 0);
+            if (!is_fully_reflected(type, first)) {
+                log::error(
+                    "Can't snapshot component {}, some of its fields are not "
+                    "reflected",
+                    type.full_name()
+                );
+                return false;
+            }
+        }
+        archetypes.push_back(archetype);
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        log::error("Can't write snapshot: {}", path.string());
+        return false;
+    }
+    auto write = [&](const void* data, std::size_t size) {
+        out.write(
+            static_cast<const char*>(data),
+            static_cast<std::streamsize>(size)
+        );
+    };
+
+    SnapshotHeader header {
+        .m_magic = {},
+        .m_version = c_snapshot_version,
+        .m_slot_count = m_entity_index.size(),
+        .m_free_count = m_free_indices.size(),
+        .m_archetype_count = archetypes.size(),
+    };
+    std::memcpy(header.m_magic, c_snapshot_magic, sizeof(header.m_magic));
+    write(&header, sizeof(header));
+    std::vector<std::uint32_t> generations(m_entity_index.size());
+    for (std::size_t i = 0; i < m_entity_index.size(); i++) {
+        generations[i] = m_entity_index[i].m_generation;
+    }
+    write(generations.data(), generations.size() * sizeof(std::uint32_t));
+    write(
+        m_free_indices.data(),
+        m_free_indices.size() * sizeof(std::uint32_t)
+    );
+
+    std::vector<std::byte> encoded;
+    for (Archetype* archetype : archetypes) {
+        const std::vector<Column>& columns = archetype->columns();
+        ArchetypeHeader archetype_header {
+            .m_component_count = columns.size(),
+            .m_row_count = archetype->size(),
+        };
+        write(&archetype_header, sizeof(archetype_header));
+        for (const Column& column : columns) {
+            ColumnHeader column_header {
+                .m_type = column.m_type->id(),
+                .m_size = static_cast<std::uint32_t>(column.m_element_size),
+                .m_encoding = column.m_type->trivially_copyable()
+                                  ? ColumnEncoding::Raw
+                                  : ColumnEncoding::Reflected,
+            };
+            write(&column_header, sizeof(column_header));
+        }
+        write(archetype->entities().data(), archetype->size() * sizeof(Entity));
+
+        for (std::size_t column = 0; column < columns.size(); column++) {
+            const refl::Type& type = *columns[column].m_type;
+            if (type.trivially_copyable()) {
+                // one write per chunk
+                for (std::size_t chunk = 0; chunk < archetype->chunk_count();
+                     chunk++) {
+                    write(
+                        archetype->get_chunk_column(chunk, column),
+                        archetype->chunk_size(chunk) * type.size()
+                    );
+                }
+                continue;
+            }
+            encoded.clear();
+            for (std::size_t row = 0; row < archetype->size(); row++) {
+                encode(type, archetype->get_component(column, row), encoded);
+            }
+            std::uint64_t size = encoded.size();
+            write(&size, sizeof(size));
+            write(encoded.data(), encoded.size());
+        }
+    }
+    out.close();
+    if (!out) {
+        log::error("Failed to write snapshot: {}", path.string());
+        return false;
+    }
+    return true;
+}
+
+bool World::load_snapshot(const std::filesystem::path& path) {
+    flush_reserved_entities();
+    if (entity_count() != 0) {
+        log::error("Snapshots only load into a world without entities");
+        return false;
+    }
+    MappedFile file(path);
+    if (!file) {
+        log::error("Can't read snapshot: {}", path.string());
+        return false;
+    }
+    SnapshotReader in(file.bytes());
+    SnapshotHeader header;
+    if (!in.read(header) ||
+        std::memcmp(header.m_magic, c_snapshot_magic, sizeof(header.m_magic)
+        ) != 0 ||
+        header.m_version != c_snapshot_version) {
+        log::error("Not a snapshot: {}", path.string());
+        return false;
+    }
+    auto corrupt = [&] {
+        log::error("Corrupt snapshot: {}", path.string());
+        return false;
+    };
+
+    // The whole table is checked before the world is touched, so a bad file
+    // leaves it empty.
+    std::vector<std::uint32_t> generations;
+    std::vector<std::uint32_t> free;
+    if (!in.read_array(generations, header.m_slot_count) ||
+        !in.read_array(free, header.m_free_count)) {
+        return corrupt();
+    }
+    // every slot is either free or holds one entity
+    std::vector<bool> claimed(header.m_slot_count, false);
+    auto claim = [&](std::uint32_t index) {
+        if (index >= claimed.size() || claimed[index]) {
+            return false;
+        }
+        claimed[index] = true;
+        return true;
+    };
+    for (std::uint32_t index : free) {
+        if (!claim(index)) {
+            return corrupt();
+        }
+    }
+
+    struct Table {
+        ComponentVector m_components;
+        std::vector<Entity> m_entities;
+        std::vector<std::span<const std::byte>> m_columns;
+    };
+    // grown as records are read, the header count alone isn't trusted
+    std::vector<Table> tables;
+    for (std::uint64_t i = 0; i < header.m_archetype_count; i++) {
+        Table& table = tables.emplace_back();
+        ArchetypeHeader archetype_header;
+        if (!in.read(archetype_header)) {
+            return corrupt();
+        }
+        std::vector<ColumnHeader> columns;
+        if (!in.read_array(columns, archetype_header.m_component_count) ||
+            !in.read_array(table.m_entities, archetype_header.m_row_count)) {
+            return corrupt();
+        }
+        for (Entity entity : table.m_entities) {
+            if (!claim(entity.index) ||
+                generations[entity.index] != entity.generation) {
+                return corrupt();
+            }
+        }
+        for (const ColumnHeader& column : columns) {
+            const refl::Type* type = refl::find_type(column.m_type);
+            if (type == nullptr) {
+                log::error(
+                    "Snapshot {} has a component of unknown type {:#x}",
+                    path.string(),
+                    column.m_type
+                );
+                return false;
+            }
+            bool raw = column.m_encoding == ColumnEncoding::Raw;
+            if (type->size() != column.m_size ||
+                raw != type->trivially_copyable() ||
+                !is_encodable(*type)) {
+                log::error(
+                    "Component {} changed since snapshot {} was saved",
+                    type->full_name(),
+                    path.string()
+                );
+                return false;
+            }
+            std::uint64_t size = 0;
+            const std::byte* data = nullptr;
+            if (raw) {
+                data = in.take(archetype_header.m_row_count, column.m_size);
+                size = archetype_header.m_row_count * column.m_size;
+            } else if (in.read(size)) {
+                data = in.take(size);
+            }
+            if (data == nullptr) {
+                return corrupt();
+            }
+            table.m_components.push_back(type);
+            table.m_columns.push_back({data, size});
+        }
+        ComponentVector sorted = table.m_components;
+        std::ranges::sort(sorted, ComponentLess {});
+        auto same = [](const refl::Type* lhs, const refl::Type* rhs) {
+            return *lhs == *rhs;
+        };
+        if (std::ranges::adjacent_find(sorted, same) != sorted.end()) {
+            return corrupt();
+        }
+    }
+    if (std::ranges::find(claimed, false) != claimed.end()) {
+        return corrupt();
+    }
+
+    m_entity_index.resize(header.m_slot_count);
+    for (std::size_t i = 0; i < m_entity_index.size(); i++) {
+        m_entity_index[i] = {nullptr, 0, generations[i]};
+    }
+    m_free_indices = std::move(free);
+    m_free_cursor = static_cast<std::int64_t>(m_free_indices.size());
+
+    bool decoded = true;
+    for (Table& table : tables) {
+        Archetype* archetype = get_or_create_archetype(table.m_components);
+        std::size_t first =
+            archetype->allocate_rows(table.m_entities, m_change_tick);
+        std::size_t count = table.m_entities.size();
+        for (std::size_t i = 0; i < count; i++) {
+            Entity entity = table.m_entities[i];
+            m_entity_index[entity.index] = {
+                archetype,
+                first + i,
+                entity.generation,
+            };
+        }
+        for (std::size_t i = 0; i < table.m_components.size(); i++) {
+            const refl::Type& type = *table.m_components[i];
+            std::size_t column = archetype->find_column(type);
+            const std::byte* data = table.m_columns[i].data();
+            if (type.trivially_copyable()) {
+                // one copy per chunk
+                std::size_t row = first;
+                std::size_t left = count;
+                while (left > 0) {
+                    std::size_t n = std::min(
+                        left,
+                        archetype->chunk_capacity() -
+                            (row & archetype->chunk_mask())
+                    );
+                    std::memcpy(
+                        archetype->get_component(column, row),
+                        data,
+                        n * type.size()
+                    );
+                    data += n * type.size();
+                    row += n;
+                    left -= n;
+                }
+                continue;
+            }
+            SnapshotReader rows(table.m_columns[i]);
+            for (std::size_t row = first; row < first + count; row++) {
+                void* component = archetype->get_component(column, row);
+                type.default_construct(component);
+                if (decoded && !decode(type, component, rows)) {
+                    decoded = false;
+                }
+            }
+        }
+    }
+    if (!decoded) {
+        log::error(
+            "Corrupt snapshot: {}, some components were left at their "
+            "defaults",
+            path.string()
+        );
+    }
+    return decoded;
+}
+
+} // namespace triple::ecs
@@ -1,37 +1,137 @@
 module;
+#include <algorithm>
+#include <memory>
 #include <string>
+#include <utility>
+#include <vector>
 
 module triple.ecs;
 import triple.refl;
 
 namespace triple::ecs {
 
+// Runs a callback taking SystemCommands, for systems assembled by hand.
+class SystemCallback final : public SystemRunner {
+  public:
+    SystemCallback(System::Callback callback) :
+        m_callback(std::move(callback)) {}
+
+    void run(System& system) override { m_callback(system.m_commands); }
+
+  private:
+    System::Callback m_callback;
+};
+
 System::System(World& world, SystemId id) :
     m_world(world), m_id(id), m_commands(*this) {}
 
+System& System::callback(Callback func) {
+    m_runner = std::make_unique<SystemCallback>(std::move(func));
+    // the callback may reach commands and writers at any time
+    m_has_deferred = true;
+    return *this;
+}
+
+void System::run() {
+    m_this_run = m_world.increment_change_tick();
+    if (m_runner) {
+        m_runner->run(*this);
+    }
+    m_last_run = m_this_run;
+}
+
+namespace {
+
+bool intersects(
+    const std::vector<const refl::Type*>& lhs,
+    const std::vector<const refl::Type*>& rhs
+) {
+    return std::ranges::any_of(lhs, [&](const refl::Type* type) {
+        return std::ranges::find(rhs, type) != rhs.end();
+    });
+}
+
+void add_unique(std::vector<const refl::Type*>& types, const refl::Type& type) {
+    if (std::ranges::find(types, &type) == types.end()) {
+        types.push_back(&type);
+    }
+}
+
+} // namespace
+
+bool SystemAccess::conflicts_with(const SystemAccess& other) const {
+    return m_component_writes.intersects(other.m_component_reads) ||
+           m_component_writes.intersects(other.m_component_writes) ||
+           other.m_component_writes.intersects(m_component_reads) ||
+           intersects(m_resource_writes, other.m_resource_reads) ||
+           intersects(m_resource_writes, other.m_resource_writes) ||
+           intersects(other.m_resource_writes, m_resource_reads) ||
+           (m_spawns && other.m_spawns);
+}
+
 System& System::add_query(const std::string& name, ComponentVector types) {
-    m_queries[name] = &m_world.query(types);
+    return add_query(name, QueryDescriptor {.m_components = std::move(types)});
+}
+
+System& System::add_query(
+    const std::string& name,
+    const QueryDescriptor& descriptor
+) {
+    QueryAccess access;
+    access.m_writes = Signature(descriptor.m_components);
+    return add_query(name, descriptor, access);
+}
+
+System& System::add_query(
+    const std::string& name,
+    const QueryDescriptor& descriptor,
+    const QueryAccess& access
+) {
+    m_queries[name] = &m_world.query(descriptor);
+    m_access.m_component_reads |= access.m_reads;
+    m_access.m_component_writes |= access.m_writes;
     return *this;
 }
 
 System& System::add_event_reader(const refl::Type& event_type) {
     m_event_readers.emplace(event_type.id(), m_world.get_events(event_type));
+    add_unique(m_access.m_event_reads, event_type);
     return *this;
 }
 
 System& System::add_event_wrtier(const refl::Type& event_type) {
-    m_event_writers.emplace(event_type.id(), m_world.get_events(event_type));
+    // one channel per system, opened once
+    m_event_writers.try_emplace(
+        event_type.id(),
+        m_world.get_events(event_type)
+    );
+    add_unique(m_access.m_event_writes, event_type);
+    m_has_deferred = true;
     return *this;
 }
 
-System& System::add_resource(const refl::Type& resource_type) {
-    m_resources.emplace(
-        resource_type.id(),
-        m_world.get_resource(resource_type)
+System& System::add_resource(const refl::Type& resource_type, bool read_only) {
+    add_unique(
+        read_only ? m_access.m_resource_reads : m_access.m_resource_writes,
+        resource_type
     );
     return *this;
 }
 
+GenericResource System::resource(const refl::Type& resource_type) {
+    auto iter = m_resources.find(resource_type.id());
+    if (iter != m_resources.end()) {
+        return iter->second;
+    }
+    GenericResource resource = m_world.get_resource(resource_type);
+    if (resource.get()) {
+        m_resources.emplace(resource_type.id(), resource);
+    }
+    return resource;
+}
+
+ThreadPool& System::thread_pool() { return m_world.thread_pool(); }
+
 SystemCommands::SystemCommands(System& system) : m_system(system) {}
 
 GenericQuery& SystemCommands::query(const std::string& name) {
@@ -46,12 +146,12 @@ GenericEventWriter& SystemCommands::event_writer(const refl::Type& event_type) {
     return m_system.m_event_writers.at(event_type.id());
 }
 
-GenericResource& SystemCommands::resource(const refl::Type& resource_type) {
-    return m_system.m_resources.at(resource_type.id());
+GenericResource SystemCommands::resource(const refl::Type& resource_type) {
+    return m_system.resource(resource_type);
 }
 
 Commands SystemCommands::commands() {
-    return Commands {m_system.m_world};
+    return Commands {m_system.m_world, m_system.m_command_buffer};
 }
 
 } // namespace triple::ecs
@@ -0,0 +1,176 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <string>
+#include <tuple>
+#include <vector>
+
+import triple.ecs;
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+struct Position {
+    float x, y;
+};
+
+struct Velocity {
+    float x, y;
+};
+
+struct Label {
+    std::string text;
+};
+
+struct Tally {
+    static inline int copies = 0;
+    Tally() = default;
+    Tally(const Tally&) { copies++; }
+    Tally(Tally&&) noexcept = default;
+    Tally& operator=(const Tally&) {
+        copies++;
+        return *this;
+    }
+    Tally& operator=(Tally&&) noexcept = default;
+};
+
+TEST_CASE("Bundle spawn", "[ecs][commands]") {
+    ecs::World world;
+    ecs::Entity e = world.spawn(
+        Position {1, 2},
+        Velocity {3, 4},
+        Label {"bundle"}
+    );
+    // root archetype plus the bundle archetype, no intermediate ones
+    REQUIRE(world.archetypes().size() == 2);
+    REQUIRE(world.get_component<Position>(e).y == 2);
+    REQUIRE(world.get_component<Velocity>(e).x == 3);
+    REQUIRE(world.get_component<Label>(e).text == "bundle");
+
+    // same bundle in another order reuses the archetype
+    ecs::Entity f = world.spawn(Label {"f"}, Velocity {}, Position {});
+    REQUIRE(world.archetypes().size() == 2);
+    REQUIRE(world.get_component<Label>(f).text == "f");
+}
+
+TEST_CASE("Batch spawn", "[ecs][commands]") {
+    ecs::World world;
+    ecs::Entity first = world.entity();
+    world.despawn(first);
+
+    // spans several chunks and skips the recycled slot
+    auto entities = world.spawn_batch(5000, Position {1, 2}, Label {"batch"});
+    REQUIRE(entities.size() == 5000);
+    REQUIRE(entities[0].index != first.index);
+    REQUIRE(world.entity_count() == 5000);
+    for (ecs::Entity e : entities) {
+        REQUIRE(world.get_component<Position>(e).y == 2);
+        REQUIRE(world.get_component<Label>(e).text == "batch");
+    }
+
+    auto generated = world.spawn_batch(3000, [](std::size_t i) {
+        return std::tuple {
+            Velocity {static_cast<float>(i), 0},
+            Position {0, static_cast<float>(i)},
+        };
+    });
+    REQUIRE(generated[0].index == entities[4999].index + 1);
+    for (std::size_t i = 0; i < generated.size(); i++) {
+        REQUIRE(world.get_component<Velocity>(generated[i]).x == i);
+        REQUIRE(world.get_component<Position>(generated[i]).y == i);
+    }
+    REQUIRE(world.archetypes().size() == 3);
+
+    // batches mix with the regular per-entity paths
+    world.despawn(entities[10]);
+    world.add_component(generated[7], Label {"seven"});
+    REQUIRE(world.get_component<Label>(entities[4999]).text == "batch");
+    REQUIRE(world.get_component<Position>(generated[7]).y == 7);
+}
+
+TEST_CASE("Command coalescing", "[ecs][commands]") {
+    ecs::World world;
+    ecs::Commands commands(world);
+
+    ecs::Entity e = commands.spawn()
+                        .add(Position {1, 2})
+                        .add(Velocity {3, 4})
+                        .add(Label {"a"})
+                        .id();
+    world.run_commands();
+    REQUIRE(world.archetypes().size() == 2);
+    REQUIRE(world.get_component<Label>(e).text == "a");
+
+    // later edits override earlier ones, an add cancels a pending remove
+    commands.entity(e)
+        .remove<Velocity>()
+        .add(Position {5, 6})
+        .add(Velocity {7, 8})
+        .remove<Label>()
+        .add(Position {9, 10});
+    world.run_commands();
+    REQUIRE(world.archetypes().size() == 3);
+    REQUIRE_FALSE(world.has_component<Label>(e));
+    REQUIRE(world.get_component<Position>(e).x == 9);
+    REQUIRE(world.get_component<Velocity>(e).y == 8);
+
+    // entities spawned through commands have nothing until they are applied
+    ecs::EntityCommands spawned = commands.spawn().add(Position {});
+    REQUIRE_FALSE(spawned.has_component<Position>());
+    world.run_commands();
+    REQUIRE(spawned.has_component<Position>());
+
+    // buffered values are moved into the world, also over existing ones
+    Tally::copies = 0;
+    commands.entity(e).add(Tally {});
+    world.run_commands();
+    commands.entity(e).add(Tally {});
+    world.run_commands();
+    REQUIRE(Tally::copies == 0);
+
+    // edits on a despawned entity are dropped
+    commands.entity(e).despawn();
+    commands.entity(e).add(Label {"gone"});
+    world.run_commands();
+    REQUIRE_FALSE(world.has_entity(e));
+}
+
+TEST_CASE("Command buffer reuse", "[ecs][commands]") {
+    ecs::World world;
+    ecs::Commands commands(world);
+    std::vector<ecs::Entity> entities;
+    std::size_t reserved = 0;
+
+    for (int frame = 0; frame < 4; frame++) {
+        entities.clear();
+        for (int i = 0; i < 10000; i++) {
+            entities.push_back(commands.spawn()
+                                   .add(Position {1, 2})
+                                   .add(Label {"a label too long for SSO"})
+                                   .id());
+        }
+        if (frame == 1) {
+            reserved = world.command_buffer().reserved_bytes();
+        } else if (frame > 1) {
+            // the arena is rewound and reused, never grown again
+            REQUIRE(world.command_buffer().reserved_bytes() == reserved);
+        }
+        world.run_commands();
+        REQUIRE(world.entity_count() == 10000);
+        REQUIRE(world.get_component<Label>(entities[123]).text.size() == 24);
+
+        for (ecs::Entity e : entities) {
+            commands.entity(e).despawn();
+        }
+        world.run_commands();
+        REQUIRE(world.entity_count() == 0);
+    }
+
+    // commands queued while applying run in the same pass
+    world.add_command([](ecs::World& world) {
+        ecs::Commands(world).spawn().add(Velocity {1, 1});
+    });
+    world.run_commands();
+    REQUIRE(world.query<Velocity>().matched().size() == 1);
+    REQUIRE(world.entity_count() == 1);
+}
@@ -0,0 +1,71 @@
+#include <catch2/catch_test_macros.hpp>
+#include <string>
+#include <vector>
+
+import triple.ecs;
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+struct Name {
+    std::string value;
+};
+
+struct Path {
+    std::vector<int> points;
+};
+
+struct Counted {
+    static inline int alive = 0;
+    Counted() { alive++; }
+    Counted(const Counted&) { alive++; }
+    Counted(Counted&&) noexcept { alive++; }
+    Counted& operator=(const Counted&) = default;
+    ~Counted() { alive--; }
+};
+
+TEST_CASE("Non-trivial components", "[ecs][component]") {
+    REQUIRE_FALSE(refl::type<Name>().trivially_relocatable());
+    REQUIRE(refl::type<Name>().align() == alignof(Name));
+
+    {
+        ecs::World world;
+        std::vector<ecs::Entity> entities;
+        for (int i = 0; i < 100; i++) {
+            ecs::Entity e = world.entity();
+            world.add_component(e, Name {std::string(64, 'a' + i % 26)});
+            world.add_component<Counted>(e);
+            entities.push_back(e);
+        }
+        REQUIRE(Counted::alive == 100);
+
+        // archetype moves relocate the strings instead of copying bytes
+        for (int i = 0; i < 100; i += 2) {
+            world.add_component(entities[i], Path {{i, i + 1}});
+        }
+        for (int i = 0; i < 100; i += 3) {
+            world.remove_component<Counted>(entities[i]);
+        }
+        for (int i = 0; i < 100; i += 5) {
+            world.despawn(entities[i]);
+        }
+        for (int i = 0; i < 100; i++) {
+            if (i % 5 == 0)
+                continue;
+            auto& name = world.get_component<Name>(entities[i]);
+            REQUIRE(name.value == std::string(64, 'a' + i % 26));
+            if (i % 2 == 0) {
+                auto& path = world.get_component<Path>(entities[i]);
+                REQUIRE(path.points[1] == i + 1);
+            }
+        }
+        int expected = 0;
+        for (int i = 0; i < 100; i++) {
+            if (i % 3 != 0 && i % 5 != 0)
+                expected++;
+        }
+        REQUIRE(Counted::alive == expected);
+    }
+    REQUIRE(Counted::alive == 0);
+}
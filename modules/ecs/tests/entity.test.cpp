@@ -0,0 +1,52 @@
+#include <catch2/catch_test_macros.hpp>
+
+import triple.ecs;
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+struct Health {
+    int value;
+};
+
+namespace triple::refl {
+template<>
+const Type& type<Health>() {
+    static Type ty("Health", sizeof(Health));
+    return ty;
+}
+} // namespace triple::refl
+
+TEST_CASE("Entity generations", "[ecs][entity]") {
+    ecs::World world;
+    ecs::Entity a = world.entity();
+    ecs::Entity b = world.entity();
+    world.add_component(a, Health {1});
+    world.add_component(b, Health {2});
+    REQUIRE(world.entity_count() == 2);
+
+    REQUIRE(world.despawn(a));
+    REQUIRE_FALSE(world.has_entity(a));
+    REQUIRE_FALSE(world.despawn(a));
+    REQUIRE(world.get_component<Health>(b).value == 2);
+
+    ecs::Entity c = world.entity();
+    REQUIRE(c.index == a.index);
+    REQUIRE(c.generation != a.generation);
+    REQUIRE(world.has_entity(c));
+    REQUIRE_FALSE(world.has_entity(a));
+    REQUIRE(world.entity_count() == 2);
+
+    REQUIRE_FALSE(world.has_entity(ecs::Entity {}));
+
+    // another Type registered under the same name is the same component
+    refl::Type alias("Health", sizeof(Health));
+    REQUIRE(world.has_component(b, alias));
+    REQUIRE(
+        world.get_component(b, alias).address() ==
+        &world.get_component<Health>(b)
+    );
+    world.remove_component(b, alias);
+    REQUIRE_FALSE(world.has_component<Health>(b));
+}
@@ -1,4 +1,6 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <vector>
 
 import triple.ecs;
 import triple.refl;
@@ -19,27 +21,135 @@ const Type& type<MyEvent>() {
 } // namespace triple::refl
 
 TEST_CASE("Event", "[event]") {
-    ecs::Events events(refl::type<MyEvent>());
+    ecs::Events<MyEvent> events;
     events.send(MyEvent {42});
     ecs::GenericEventReader reader(events);
     auto evt = reader.next();
     REQUIRE(evt);
-    REQUIRE(evt->cast<MyEvent>().value == 42);
+    REQUIRE(evt.value<MyEvent>().value == 42);
+    REQUIRE_FALSE(reader.next());
+}
+
+TEST_CASE("Event buffers", "[event]") {
+    ecs::Events<MyEvent> events;
+    ecs::GenericEventReader state(events);
+    ecs::EventReader<MyEvent> reader(state);
+
+    events.send_batch(std::vector<MyEvent> {{0}, {1}, {2}});
+    events.update();
+    events.send(MyEvent {3});
+    REQUIRE(events.size() == 4);
+
+    // older events first, read by reference out of both buffers
+    auto unread = reader.read();
+    REQUIRE(unread.first().size() == 3);
+    REQUIRE(unread.second().size() == 1);
+    int expected = 0;
+    for (const MyEvent& event : unread) {
+        REQUIRE(event.value == expected++);
+    }
+    REQUIRE(expected == 4);
+    REQUIRE(reader.empty());
+
+    // events live for two updates
+    events.send(MyEvent {4});
+    events.update();
+    REQUIRE(events.size() == 2);
+    REQUIRE(reader.next()->value == 4);
+    REQUIRE(reader.next() == nullptr);
+    events.update();
+    REQUIRE(events.size() == 0);
+
+    // a reader that fell behind skips what was dropped
+    events.send(MyEvent {5});
+    events.update();
+    events.update();
+    events.send(MyEvent {6});
+    REQUIRE(reader.size() == 1);
+    REQUIRE(reader.next()->value == 6);
 }
 
 TEST_CASE("Events & World", "[event]") {
     ecs::World world;
     world.add_event<MyEvent>();
-    world
-        .system(+[](ecs::EventWriter<MyEvent> writer) {
-            writer.send(MyEvent {42});
-        })
-        .run();
-    world
-        .system(+[](ecs::EventReader<MyEvent> reader) {
-            auto evt = reader.next();
-            REQUIRE(evt);
-            REQUIRE(evt->value == 42);
-        })
-        .run();
+    auto& writer = world.system(+[](ecs::EventWriter<MyEvent> writer) {
+        writer.send(MyEvent {42});
+    });
+    std::vector<int> received;
+    auto& reader = world.system([&](ecs::EventReader<MyEvent> reader) {
+        for (const MyEvent& event : reader.read()) {
+            received.push_back(event.value);
+        }
+    });
+
+    // sent events become readable at the next sync point
+    writer.run();
+    reader.run();
+    REQUIRE(received.empty());
+    world.run_commands();
+    reader.run();
+    REQUIRE(received == std::vector<int> {42});
+
+    // the reader's position is kept between runs
+    world.update_events();
+    reader.run();
+    REQUIRE(received.size() == 1);
+    writer.run();
+    writer.run();
+    world.update_events();
+    reader.run();
+    REQUIRE(received == std::vector<int> {42, 42, 42});
+}
+
+TEST_CASE("Parallel event writers", "[event]") {
+    ecs::World world;
+    ThreadPool pool(4);
+    world.set_thread_pool(&pool);
+    world.add_event<MyEvent>();
+    world.add_schedule(0);
+    world.get_schedule(0).set_executor(ecs::Executor::Parallel);
+
+    // writers run alongside each other, their events merge in system order
+    for (int s = 0; s < 4; s++) {
+        world.add_system(
+            0,
+            [s](ecs::EventWriter<MyEvent> writer) {
+                std::vector<MyEvent> batch;
+                for (int i = 0; i < 500; i++) {
+                    batch.push_back({s * 1000 + i});
+                }
+                writer.send(MyEvent {s * 1000 - 1});
+                writer.send_batch(batch);
+            },
+            {.label = "write"}
+        );
+    }
+    std::vector<int> received;
+    world.add_system(
+        0,
+        [&](ecs::EventReader<MyEvent> reader) {
+            for (const MyEvent& event : reader.read()) {
+                received.push_back(event.value);
+            }
+        },
+        {.after = {"write"}}
+    );
+
+    auto& schedule = world.get_schedule(0);
+    REQUIRE(schedule.stage_count() == 2);
+    for (std::size_t i = 0; i < 4; i++) {
+        REQUIRE(schedule.dependencies(i).empty());
+    }
+
+    for (int frame = 0; frame < 3; frame++) {
+        world.update_events();
+        received.clear();
+        world.run_schedule(0);
+        REQUIRE(received.size() == 4 * 501);
+        for (int s = 0; s < 4; s++) {
+            for (int i = 0; i < 501; i++) {
+                REQUIRE(received[s * 501 + i] == s * 1000 + i - 1);
+            }
+        }
+    }
 }
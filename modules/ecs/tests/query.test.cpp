@@ -0,0 +1,289 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstddef>
+#include <set>
+#include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+import triple.ecs;
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+template<int N>
+struct Flag {
+    int value = N;
+};
+
+TEST_CASE("Archetype signatures", "[ecs][query]") {
+    ecs::World world;
+    // one entity per subset of six component types
+    [&]<int... Ns>(std::integer_sequence<int, Ns...>) {
+        for (int mask = 0; mask < 64; mask++) {
+            ecs::Entity e = world.entity();
+            ((mask & (1 << Ns) ? world.add_component(e, Flag<Ns> {}) : void()),
+             ...);
+        }
+    }(std::make_integer_sequence<int, 6> {});
+
+    // every subset got its own archetype
+    REQUIRE(world.archetypes().size() == 64);
+    for (ecs::Archetype* archetype : world.archetypes()) {
+        REQUIRE(archetype->size() == 1);
+        REQUIRE(world.get_archetype(archetype->components()) == archetype);
+    }
+
+    std::size_t count = 0;
+    for (auto [a, c] : world.query<Flag<0>, Flag<2>>()) {
+        REQUIRE(a.value == 0);
+        REQUIRE(c.value == 2);
+        count++;
+    }
+    REQUIRE(count == 16);
+
+    count = 0;
+    for (auto [e, f] : world.query<ecs::Entity, Flag<5>>()) {
+        REQUIRE(world.has_component<Flag<5>>(e));
+        count++;
+    }
+    REQUIRE(count == 32);
+
+    // queries created before their archetypes pick them up later
+    auto query = world.query<Flag<6>>();
+    REQUIRE(query.empty());
+    world.add_component(world.entity(), Flag<6> {});
+    REQUIRE_FALSE(query.empty());
+
+    // new component types met from several threads at once
+    ThreadPool pool(4);
+    std::vector<std::size_t> indices(64);
+    pool.parallel_for(indices.size(), [&](std::size_t i) {
+        const refl::Type* types[] = {
+            &refl::type<Flag<20>>(),
+            &refl::type<Flag<21>>(),
+            &refl::type<Flag<22>>(),
+            &refl::type<Flag<23>>(),
+        };
+        indices[i] = ecs::component_index(*types[i % 4]);
+    });
+    for (std::size_t i = 0; i < indices.size(); i++) {
+        REQUIRE(indices[i] == indices[i % 4]);
+    }
+    REQUIRE(std::set(indices.begin(), indices.end()).size() == 4);
+}
+
+TEST_CASE("Query filters", "[ecs][query]") {
+    ecs::World world;
+    for (int i = 0; i < 40; i++) {
+        ecs::Entity e = world.entity();
+        world.add_component(e, Flag<0> {i});
+        if (i % 2 == 0)
+            world.add_component(e, Flag<1> {});
+        if (i % 4 == 0)
+            world.add_component(e, Flag<2> {});
+        if (i % 5 == 0)
+            world.add_component(e, Flag<3> {});
+    }
+
+    auto count = [](auto query) {
+        std::size_t n = 0;
+        for (auto iter = query.begin(); iter != query.end(); ++iter) {
+            n++;
+        }
+        return n;
+    };
+    REQUIRE(count(world.query<Flag<0>, ecs::With<Flag<1>>>()) == 20);
+    REQUIRE(count(world.query<Flag<0>, ecs::Without<Flag<1>>>()) == 20);
+    REQUIRE(
+        count(world.query<
+              Flag<0>,
+              ecs::With<Flag<1>>,
+              ecs::Without<Flag<2>>>()) == 10
+    );
+    // even, or a multiple of 5
+    REQUIRE(count(world.query<Flag<0>, ecs::Or<Flag<1>, Flag<3>>>()) == 24);
+    // odd, or a multiple of 4
+    REQUIRE(
+        count(world.query<
+              Flag<0>,
+              ecs::Or<ecs::Without<Flag<1>>, ecs::With<Flag<2>>>>()) == 30
+    );
+
+    // filters fetch nothing, Optional fetches a pointer
+    for (auto [flag, multiple_of_five] :
+         world.query<const Flag<0>, ecs::Optional<Flag<3>>, ecs::With<Flag<1>>>(
+         )) {
+        static_assert(std::is_same_v<decltype(flag), const Flag<0>&>);
+        REQUIRE(flag.value % 2 == 0);
+        REQUIRE((multiple_of_five != nullptr) == (flag.value % 5 == 0));
+    }
+
+    // random access by entity
+    auto evens = world.query<ecs::Entity, Flag<0>, ecs::With<Flag<1>>>();
+    auto all = world.query<ecs::Entity>();
+    std::vector<ecs::Entity> entities;
+    for (auto [entity] : all) {
+        entities.push_back(entity);
+    }
+    for (ecs::Entity entity : entities) {
+        auto items = evens.get(entity);
+        REQUIRE(items.has_value() == world.has_component<Flag<1>>(entity));
+        if (items) {
+            auto [found, flag] = *items;
+            REQUIRE(found == entity);
+            REQUIRE(flag.value % 2 == 0);
+        }
+    }
+    world.despawn(entities[0]);
+    REQUIRE_FALSE(evens.get(entities[0]));
+    REQUIRE_FALSE(evens.get(ecs::Entity {}));
+
+    // queries differing only in filters are distinct
+    REQUIRE(
+        &world.query(ecs::Query<Flag<0>, ecs::With<Flag<1>>>::descriptor()) !=
+        &world.query(ecs::Query<Flag<0>, ecs::Without<Flag<1>>>::descriptor())
+    );
+}
+
+static std::size_t s_changed = 0;
+static std::size_t s_added = 0;
+
+TEST_CASE("Change detection", "[ecs][query]") {
+    ecs::World world;
+    auto entities = world.spawn_batch(5000, Flag<0> {}, Flag<1> {});
+
+    auto& reader = world.system(
+        +[](ecs::Query<const Flag<0>, ecs::Changed<Flag<0>>> changed,
+            ecs::Query<ecs::Entity, ecs::Added<Flag<1>>> added) {
+            s_changed = 0;
+            for (auto [flag] : changed) {
+                s_changed++;
+            }
+            s_added = 0;
+            for (auto [entity] : added) {
+                s_added++;
+            }
+        }
+    );
+    auto& writer = world.system(
+        +[](ecs::Query<Flag<0>, ecs::With<Flag<2>>> query) {
+            for (auto [flag] : query) {
+                flag.value++;
+            }
+        }
+    );
+    auto check = [&](std::size_t changed, std::size_t added) {
+        reader.run();
+        REQUIRE(s_changed == changed);
+        REQUIRE(s_added == added);
+    };
+
+    // everything is new on the first run, nothing on the next
+    check(5000, 5000);
+    check(0, 0);
+
+    // assigning through add_component counts as a change
+    world.add_component(entities[10], Flag<0> {7});
+    check(1, 0);
+
+    // moving to another archetype keeps the ticks
+    world.add_component(entities[4000], Flag<2> {});
+    check(0, 0);
+
+    // mutable query access marks the rows it hands out
+    writer.run();
+    check(1, 0);
+    check(0, 0);
+
+    world.spawn(Flag<0> {}, Flag<1> {});
+    check(1, 1);
+
+    // swap-removes relocate old ticks without marking anything
+    world.despawn(entities[0]);
+    world.despawn(entities[2000]);
+    check(0, 0);
+}
+
+TEST_CASE("Change ticks wrapping around", "[ecs][query]") {
+    ecs::World world;
+    ecs::Entity entity = world.spawn(Flag<0> {});
+    auto& reader = world.system(
+        +[](ecs::Query<const Flag<0>, ecs::Changed<Flag<0>>> changed) {
+            s_changed = 0;
+            for (auto [flag] : changed) {
+                s_changed++;
+            }
+        }
+    );
+    reader.run();
+    REQUIRE(s_changed == 1);
+
+    // well past half the tick range, where an unclamped tick would wrap
+    // around and look new again
+    for (int i = 0; i < 9; i++) {
+        world.advance_change_tick(ecs::Tick {1} << 28);
+        world.check_change_ticks();
+        reader.run();
+        REQUIRE(s_changed == 0);
+    }
+
+    world.add_component(entity, Flag<0> {3});
+    reader.run();
+    REQUIRE(s_changed == 1);
+}
+
+TEST_CASE("Parallel iteration", "[ecs][query]") {
+    ecs::World world;
+    world.spawn_batch(20000, [](std::size_t i) {
+        return std::tuple {Flag<0> {static_cast<int>(i)}};
+    });
+    world.spawn_batch(3000, [](std::size_t i) {
+        return std::tuple {Flag<0> {static_cast<int>(i)}, Flag<1> {}};
+    });
+    ThreadPool pool(4);
+
+    auto query = world.query<Flag<0>, ecs::Optional<const Flag<1>>>();
+    std::atomic<std::size_t> with_one = 0;
+    query.par_for_each(
+        [&](Flag<0>& flag, const Flag<1>* one) {
+            flag.value *= 2;
+            if (one != nullptr) {
+                with_one++;
+            }
+        },
+        {.batch_size = 100, .pool = &pool}
+    );
+    REQUIRE(with_one == 3000);
+
+    std::atomic<long long> sum = 0;
+    std::atomic<std::size_t> batches = 0;
+    world.query<const Flag<0>>().par_for_each_chunk(
+        [&](std::span<const Flag<0>> flags) {
+            long long local = 0;
+            for (auto& flag : flags) {
+                local += flag.value;
+            }
+            sum += local;
+            batches++;
+        },
+        {.pool = &pool}
+    );
+    REQUIRE(sum == 19999LL * 20000 + 2999LL * 3000);
+    REQUIRE(batches > 2);
+
+    // the serial fallback visits rows in iterator order
+    std::vector<ecs::Entity> serial;
+    world.query<ecs::Entity, const Flag<0>>().par_for_each(
+        [&](ecs::Entity entity, const Flag<0>&) { serial.push_back(entity); },
+        {.batch_size = 7, .serial = true}
+    );
+    std::vector<ecs::Entity> iterated;
+    for (auto [entity, flag] : world.query<ecs::Entity, const Flag<0>>()) {
+        iterated.push_back(entity);
+    }
+    REQUIRE(serial == iterated);
+}
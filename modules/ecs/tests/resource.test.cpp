@@ -1,4 +1,5 @@
 #include <catch2/catch_test_macros.hpp>
+#include <utility>
 
 import triple.ecs;
 import triple.refl;
@@ -36,3 +37,48 @@ TEST_CASE("Resource", "[ecs]") {
         })
         .run();
 }
+
+template<int N>
+struct Counter {
+    int value = N;
+    char padding[N * 16] {};
+};
+
+TEST_CASE("Resource storage", "[ecs]") {
+    ecs::World world;
+    world.add_resource(Counter<1> {});
+    world.add_resource(Counter<2> {});
+    Counter<1>* first = &*world.get_resource<Counter<1>>();
+    Counter<2>* second = &*world.get_resource<Counter<2>>();
+
+    // systems hold the resource's address, which survives adding more
+    auto& system = world.system([&](ecs::Resource<const Counter<1>> counter) {
+        REQUIRE(&*counter == first);
+    });
+    [&]<int... Ns>(std::integer_sequence<int, Ns...>) {
+        (world.add_resource(Counter<Ns + 3> {}), ...);
+    }(std::make_integer_sequence<int, 30> {});
+    system.run();
+    REQUIRE(&*world.get_resource<Counter<2>>() == second);
+    REQUIRE(world.get_resource<const Counter<32>>()->value == 32);
+
+    // adding again keeps the existing resource
+    world.get_resource<Counter<1>>()->value = 5;
+    world.add_resource(Counter<1> {});
+    REQUIRE(world.get_resource<Counter<1>>()->value == 5);
+
+    // systems can be added before the resources they take
+    int runs = 0;
+    auto& early = world.system([&](ecs::Resource<Counter<35>> counter) {
+        REQUIRE(counter->value == 35);
+        runs++;
+    });
+    world.add_resource(Counter<35> {});
+    early.run();
+    early.run();
+    REQUIRE(runs == 2);
+
+    // a missing resource is null and isn't created by the lookup
+    REQUIRE_FALSE(world.get_resource<Counter<40>>());
+    REQUIRE_FALSE(world.get_resource<Counter<40>>());
+}
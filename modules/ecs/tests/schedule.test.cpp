@@ -1,4 +1,9 @@
 #include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 
 import triple.ecs;
 import triple.refl;
@@ -21,3 +26,307 @@ TEST_CASE("Schedule", "[ecs]") {
     world.run_schedule(0);
     REQUIRE(counter == 1);
 }
+
+struct Offset {
+    float x, y;
+};
+
+struct Drift {
+    float x, y;
+};
+
+struct Gravity {
+    float value;
+};
+
+struct Frame {
+    static constexpr bool c_main_thread = true;
+
+    std::thread::id thread;
+    int count = 0;
+};
+
+TEST_CASE("Parallel schedule", "[ecs]") {
+    ecs::World world;
+    world.add_resource(Gravity {-1});
+    world.add_resource(Frame {});
+    world.spawn_batch(2000, Offset {0, 0}, Drift {1, 0});
+    world.add_schedule(0);
+    world.get_schedule(0).set_executor(ecs::Executor::Parallel);
+
+    // 0: writes Offset, reads Drift
+    world.add_system(
+        0,
+        +[](ecs::Query<Offset, const Drift> query) {
+            for (auto [offset, drift] : query) {
+                offset.x += drift.x;
+            }
+        }
+    );
+    // 1: reads Offset and Gravity, runs after 0
+    world.add_system(
+        0,
+        +[](ecs::Query<const Offset> query,
+            ecs::Resource<const Gravity> gravity) {}
+    );
+    // 2: writes Drift, runs after 0 but alongside 1
+    world.add_system(
+        0,
+        +[](ecs::Query<Drift> query, ecs::Resource<const Gravity> gravity) {
+            for (auto [drift] : query) {
+                drift.y += gravity->value;
+            }
+        }
+    );
+    // 3: writes Gravity, waits for both readers
+    world.add_system(0, +[](ecs::Resource<Gravity> gravity) {
+        gravity->value *= 2;
+    });
+    // 4 and 5: each records into its own command buffer, taking turns to
+    // reserve entities
+    world.add_system(0, +[](ecs::Commands commands) {
+        commands.spawn().add(Drift {});
+    });
+    world.add_system(0, +[](ecs::Commands commands) {
+        commands.spawn().add(Offset {});
+    });
+    // 6: main thread only through its resource
+    world.add_system(0, +[](ecs::Resource<Frame> frame) {
+        frame->thread = std::this_thread::get_id();
+        frame->count++;
+    });
+
+    auto& schedule = world.get_schedule(0);
+    using Deps = std::vector<std::size_t>;
+    REQUIRE(schedule.dependencies(0) == Deps {});
+    REQUIRE(schedule.dependencies(1) == Deps {0});
+    REQUIRE(schedule.dependencies(2) == Deps {0});
+    REQUIRE(schedule.dependencies(3) == Deps {1, 2});
+    REQUIRE(schedule.dependencies(4) == Deps {});
+    REQUIRE(schedule.dependencies(5) == Deps {4});
+    REQUIRE(schedule.dependencies(6) == Deps {});
+
+    for (int i = 0; i < 20; i++) {
+        world.run_schedule(0);
+    }
+    REQUIRE(world.get_resource<Frame>()->count == 20);
+    REQUIRE(world.get_resource<Frame>()->thread == std::this_thread::get_id());
+    // gravity doubles after both readers saw it
+    REQUIRE(world.get_resource<Gravity>()->value == -(1 << 20));
+    // commands are applied once the schedule is done
+    REQUIRE(world.entity_count() == 2040);
+    for (auto [offset, drift] :
+         world.query<const Offset, const Drift>()) {
+        REQUIRE(offset.x == 20);
+        REQUIRE(drift.y == -((1 << 20) - 1));
+    }
+}
+
+TEST_CASE("Per-system command buffers", "[ecs]") {
+    // spawned rows land in system order and get the same ids whatever
+    // thread ran the system
+    auto run = [](ecs::Executor executor, ThreadPool& pool) {
+        ecs::World world;
+        world.set_thread_pool(&pool);
+        world.add_schedule(0);
+        world.get_schedule(0).set_executor(executor);
+        for (int s = 0; s < 8; s++) {
+            world.add_system(0, [s](ecs::Commands commands) {
+                for (int i = 0; i < 100; i++) {
+                    commands.spawn().add(
+                        Drift {static_cast<float>(s), static_cast<float>(i)}
+                    );
+                }
+            });
+        }
+        std::vector<std::pair<float, float>> order;
+        std::vector<ecs::Entity> entities;
+        for (int frame = 0; frame < 3; frame++) {
+            world.run_schedule(0);
+            for (auto [entity, drift] : world.query<ecs::Entity, Drift>()) {
+                order.push_back({drift.x, drift.y});
+                entities.push_back(entity);
+                if (static_cast<int>(drift.y) % 3 == frame) {
+                    world.despawn(entity);
+                }
+            }
+        }
+        return std::pair {order, entities};
+    };
+    ThreadPool pool(4);
+    auto serial = run(ecs::Executor::Serial, pool);
+    REQUIRE(serial.first.size() > 2400);
+    REQUIRE(serial.first[0] == std::pair {0.0f, 0.0f});
+    REQUIRE(serial.first[799] == std::pair {7.0f, 99.0f});
+    for (int i = 0; i < 3; i++) {
+        REQUIRE(run(ecs::Executor::Parallel, pool) == serial);
+    }
+}
+
+TEST_CASE("Command order", "[ecs]") {
+    // flushing by hand applies the buffers in schedule order too
+    auto run = [](bool scheduled) {
+        ecs::World world;
+        world.add_schedule(0);
+        auto spawn = [](float x) {
+            return [x](ecs::Commands commands) {
+                commands.spawn().add(Drift {x, 0});
+            };
+        };
+        ecs::SystemId late =
+            world.add_system(0, spawn(1), {.after = {"early"}});
+        ecs::SystemId early =
+            world.add_system(0, spawn(0), {.label = "early"});
+        ecs::SystemId loose = world.system(spawn(2)).id();
+        if (scheduled) {
+            world.run_schedule(0);
+        } else {
+            world.run_system(late);
+            world.run_system(early);
+        }
+        world.run_system(loose);
+        world.run_commands();
+        std::vector<float> order;
+        for (auto [drift] : world.query<const Drift>()) {
+            order.push_back(drift.x);
+        }
+        return order;
+    };
+    REQUIRE(run(false) == std::vector<float> {0, 1, 2});
+    REQUIRE(run(true) == std::vector<float> {0, 1, 2});
+}
+
+TEST_CASE("Schedule stages", "[ecs]") {
+    ecs::World world;
+    world.add_schedule(0);
+    std::vector<std::string> ran;
+    std::vector<std::size_t> seen;
+    auto count = [&](ecs::Query<const Offset> query) {
+        std::size_t n = 0;
+        for (auto [offset] : query) {
+            n++;
+        }
+        seen.push_back(n);
+    };
+
+    world.add_system(
+        0,
+        [&](ecs::Query<const Offset> query) {
+            ran.push_back("late");
+            count(query);
+        },
+        {.after = {"spawn"}}
+    );
+    world.add_system(
+        0,
+        [&](ecs::Commands commands) {
+            ran.push_back("spawn");
+            commands.spawn().add(Offset {});
+        },
+        {.label = "spawn", .after = {"input"}}
+    );
+    world.add_system(
+        0,
+        [&](ecs::Query<const Offset> query) {
+            ran.push_back("same stage");
+            count(query);
+        }
+    );
+    world.add_system(0, [&] { ran.push_back("input"); }, {.label = "input"});
+    world.add_system(0, [&] { ran.push_back("first"); }, {.before = {"input"}});
+    world.get_schedule(0).add_sync_point();
+    world.add_system(0, [&](ecs::Query<const Offset> query) {
+        ran.push_back("synced");
+        count(query);
+    });
+
+    auto& schedule = world.get_schedule(0);
+    // the explicit sync point and the one after "spawn" collapse into one
+    REQUIRE(schedule.stage_count() == 2);
+    REQUIRE(schedule.stage(0).size() == 4);
+    REQUIRE(schedule.stage(1).size() == 2);
+
+    world.run_schedule(0);
+    std::vector<std::string> order {
+        "same stage",
+        "first",
+        "input",
+        "spawn",
+        "late",
+        "synced",
+    };
+    REQUIRE(ran == order);
+    // commands are only applied at the end of the stage
+    REQUIRE(seen == std::vector<std::size_t> {0, 1, 1});
+}
+
+TEST_CASE("Reserved entities", "[ecs]") {
+    ecs::World world;
+    ecs::Entity a = world.entity();
+    ecs::Entity b = world.entity();
+    world.despawn(a);
+
+    // the recycled slot goes first, then fresh ones
+    ecs::Entity c = world.reserve_entity();
+    ecs::Entity d = world.reserve_entity();
+    ecs::Entity e = world.reserve_entity();
+    REQUIRE(c.index == a.index);
+    REQUIRE(c.generation == a.generation + 1);
+    REQUIRE(d.index == b.index + 1);
+    REQUIRE(e.index == b.index + 2);
+    REQUIRE_FALSE(world.has_entity(c));
+    REQUIRE_FALSE(world.has_entity(e));
+
+    world.flush_reserved_entities();
+    REQUIRE(world.has_entity(c));
+    REQUIRE(world.has_entity(d));
+    REQUIRE(world.has_entity(e));
+    REQUIRE(world.entity_count() == 4);
+
+    // other ways of creating entities flush first
+    ecs::Entity f = world.reserve_entity();
+    ecs::Entity g = world.entity();
+    REQUIRE(world.has_entity(f));
+    REQUIRE(g.index == f.index + 1);
+}
+
+static std::size_t s_seen = 0;
+
+TEST_CASE("System parameters", "[ecs]") {
+    ecs::World world;
+    world.add_resource(Gravity {2});
+    auto& system = world.system(
+        [](ecs::Query<const Offset> query,
+           ecs::LocalResource<int> runs,
+           ecs::Resource<const Gravity> gravity) {
+            s_seen = 0;
+            for (auto [offset] : query) {
+                s_seen++;
+            }
+            *runs += static_cast<int>(gravity->value);
+            return *runs;
+        }
+    );
+
+    system.run();
+    REQUIRE(s_seen == 0);
+    REQUIRE(system.get_output().value<int>() == 2);
+
+    // state resolved at registration still sees later archetypes and values
+    world.spawn(Offset {});
+    world.spawn(Offset {}, Drift {});
+    world.get_resource<Gravity>()->value = 5;
+    system.run();
+    REQUIRE(s_seen == 2);
+    REQUIRE(system.get_output().value<int>() == 7);
+
+    // systems splitting up their own work get the world's pool
+    ThreadPool pool(2);
+    ThreadPool* seen_pool = nullptr;
+    auto& splitter = world.system([&](ThreadPool& p) { seen_pool = &p; });
+    splitter.run();
+    REQUIRE(seen_pool == &ThreadPool::shared());
+    world.set_thread_pool(&pool);
+    splitter.run();
+    REQUIRE(seen_pool == &pool);
+}
@@ -0,0 +1,152 @@
+#include <catch2/catch_test_macros.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+import triple.ecs;
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+struct Waypoint {
+    float x, y;
+};
+
+struct Nickname {
+    std::string text;
+    int rank;
+};
+
+struct Secret {
+    std::string text;
+};
+
+struct Heading {
+    float angle, speed;
+};
+
+struct Dossier {
+    std::string text;
+    int hidden;
+};
+
+TEST_CASE("Snapshots", "[ecs]") {
+    auto path = std::filesystem::temp_directory_path() / "triple-snapshot.bin";
+    refl::Cls::new_cls<Nickname>()
+        .add_member("text", &Nickname::text)
+        .add_member("rank", &Nickname::rank);
+    refl::Cls::new_cls<Dossier>().add_member("text", &Dossier::text);
+
+    SECTION("round trip") {
+        std::vector<ecs::Entity> entities;
+        std::vector<ecs::Entity> despawned;
+        {
+            ecs::World world;
+            for (ecs::Entity e : world.spawn_batch(5000, Waypoint {1, 2})) {
+                entities.push_back(e);
+            }
+            for (int i = 0; i < 100; i++) {
+                entities.push_back(world.spawn(
+                    Waypoint {float(i), 0},
+                    Nickname {"unit " + std::to_string(i), i}
+                ));
+            }
+            entities.push_back(world.entity());
+            for (int i = 0; i < 10; i++) {
+                world.despawn(entities[i * 7]);
+                despawned.push_back(entities[i * 7]);
+            }
+            world.get_component<Waypoint>(entities[4999]).x = 42;
+            REQUIRE(world.save_snapshot(path));
+        }
+
+        ecs::World world;
+        REQUIRE(world.load_snapshot(path));
+        REQUIRE(world.entity_count() == entities.size() - despawned.size());
+        for (ecs::Entity e : despawned) {
+            REQUIRE_FALSE(world.has_entity(e));
+        }
+        REQUIRE(world.get_component<Waypoint>(entities[1]).y == 2);
+        REQUIRE(world.get_component<Waypoint>(entities[4999]).x == 42);
+        for (int i = 0; i < 100; i++) {
+            ecs::Entity e = entities[5000 + i];
+            REQUIRE(world.get_component<Waypoint>(e).x == float(i));
+            auto& name = world.get_component<Nickname>(e);
+            REQUIRE(name.text == "unit " + std::to_string(i));
+            REQUIRE(name.rank == i);
+        }
+        ecs::Entity bare = entities.back();
+        REQUIRE(world.has_entity(bare));
+        REQUIRE_FALSE(world.has_component<Waypoint>(bare));
+
+        // the free list survives, so despawned slots are reused
+        ecs::Entity reused = world.entity();
+        REQUIRE(reused.index == despawned.back().index);
+        REQUIRE(reused.generation == despawned.back().generation + 1);
+        std::size_t count = 0;
+        for (auto [waypoint] : world.query<Waypoint>()) {
+            count++;
+        }
+        REQUIRE(count == 5090);
+    }
+
+    SECTION("rejected") {
+        ecs::World world;
+        world.spawn(Secret {"no members"});
+        REQUIRE_FALSE(world.save_snapshot(path));
+
+        // members that aren't reflected would be lost
+        ecs::World partial;
+        partial.spawn(Dossier {"half", 7});
+        REQUIRE_FALSE(partial.save_snapshot(path));
+
+        world.despawn(world.spawn(Waypoint {}));
+        ecs::World saved;
+        saved.spawn(Waypoint {3, 4});
+        REQUIRE(saved.save_snapshot(path));
+        REQUIRE_FALSE(world.load_snapshot(path));
+
+        // a world whose entities were all despawned is empty enough
+        ecs::World cleared;
+        cleared.despawn(cleared.spawn(Waypoint {}));
+        REQUIRE(cleared.load_snapshot(path));
+        REQUIRE(cleared.entity_count() == 1);
+
+        // patched headers: a huge archetype count, a component listed twice
+        auto patched = [&](std::size_t offset, const auto& value) {
+            ecs::World source;
+            source.spawn(Waypoint {}, Heading {});
+            REQUIRE(source.save_snapshot(path));
+            std::fstream file(
+                path,
+                std::ios::binary | std::ios::in | std::ios::out
+            );
+            file.seekp(static_cast<std::streamoff>(offset));
+            file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+            file.close();
+            ecs::World target;
+            bool loaded = target.load_snapshot(path);
+            REQUIRE(target.entity_count() == 0);
+            return loaded;
+        };
+        // header, one generation, archetype header, then the column headers
+        std::size_t archetype_count = 24;
+        std::size_t second_column = 32 + 4 + 16 + 16;
+        REQUIRE_FALSE(patched(archetype_count, ~std::uint64_t {0}));
+        // columns are in id order, the second gets the id of the first
+        refl::TypeId first_id =
+            std::min(refl::type<Waypoint>().id(), refl::type<Heading>().id());
+        REQUIRE_FALSE(patched(second_column, first_id));
+
+        std::ofstream(path, std::ios::binary | std::ios::trunc) << "garbage";
+        ecs::World empty;
+        REQUIRE_FALSE(empty.load_snapshot(path));
+        REQUIRE(empty.entity_count() == 0);
+    }
+
+    std::filesystem::remove(path);
+}
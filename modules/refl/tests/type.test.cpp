@@ -0,0 +1,55 @@
+#include <catch2/catch_test_macros.hpp>
+
+import triple.refl;
+
+using namespace triple;
+
+namespace {
+
+struct Sprite {
+    int frame;
+};
+
+struct Tile {
+    int x, y;
+};
+
+} // namespace
+
+TEST_CASE("Type ids", "[refl]") {
+    using namespace triple::refl;
+
+    SECTION("known at compile time") {
+        constexpr TypeId sprite = type_id<Sprite>();
+        static_assert(sprite != type_id<Tile>());
+        static_assert(type_id_of("abc") == type_id_of("abc"));
+        REQUIRE(type<Sprite>().id() == sprite);
+    }
+
+    SECTION("derived from the name") {
+        REQUIRE(type_id_of("") == 0xcbf29ce484222325ULL);
+        REQUIRE(type_id_of("a") == 0xaf63dc4c8601ec8cULL);
+        REQUIRE(type<Tile>().id() == type_id_of(type<Tile>().full_name()));
+    }
+
+    SECTION("looked up by id") {
+        const Type& tile = type<Tile>();
+        REQUIRE(find_type(tile.id()) == &tile);
+        REQUIRE(find_type(type_id_of("no such type")) == nullptr);
+    }
+
+    SECTION("registered by hand") {
+        const Type* found = nullptr;
+        {
+            Type scratch("Scratch", 4);
+            REQUIRE(scratch.id() == type_id_of("Scratch"));
+            found = find_type(scratch.id());
+            REQUIRE(found == &scratch);
+
+            Type again("Scratch", 4);
+            REQUIRE(again == scratch);
+            REQUIRE(find_type(again.id()) == &scratch);
+        }
+        REQUIRE(find_type(type_id_of("Scratch")) == nullptr);
+    }
+}
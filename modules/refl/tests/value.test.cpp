@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+#include <array>
+#include <memory>
+#include <string>
+#include <utility>
+
+import triple.refl;
+import triple.base;
+
+using namespace triple;
+
+namespace {
+
+struct Tracked {
+    static inline int s_alive = 0;
+
+    Tracked() { s_alive++; }
+    Tracked(const Tracked&) { s_alive++; }
+    Tracked(Tracked&&) noexcept { s_alive++; }
+    ~Tracked() { s_alive--; }
+
+    std::array<int, 64> data {};
+};
+
+} // namespace
+
+TEST_CASE("Value storage", "[refl][value]") {
+    // small objects live inline, large ones on the heap
+    refl::Value small(42);
+    refl::Value large(Tracked {});
+    REQUIRE(small.cast<int>() == 42);
+    REQUIRE(small.ref().address() != nullptr);
+    REQUIRE(Tracked::s_alive == 1);
+
+    refl::Value empty;
+    REQUIRE(empty.empty());
+    REQUIRE_FALSE(empty.ref());
+
+    // copies are deep, moves leave the source empty
+    refl::Value copy = small;
+    copy.cast<int>() = 7;
+    REQUIRE(small.cast<int>() == 42);
+    refl::Value large_copy = large;
+    REQUIRE(Tracked::s_alive == 2);
+    void* address = large.ref().address();
+    refl::Value moved = std::move(large);
+    REQUIRE(large.empty());
+    REQUIRE(moved.ref().address() == address);
+    REQUIRE(Tracked::s_alive == 2);
+
+    moved = small;
+    REQUIRE(Tracked::s_alive == 1);
+    REQUIRE(moved.cast<int>() == 42);
+    moved.swap(large_copy);
+    REQUIRE(large_copy.cast<int>() == 42);
+    moved.reset();
+    REQUIRE(Tracked::s_alive == 0);
+
+    // assigning through a reference keeps the type
+    int nine = 9;
+    small = refl::Ref(&nine);
+    REQUIRE(small.cast<int>() == 9);
+
+    // move-only types are accepted
+    refl::Value owner(std::make_unique<std::string>("owned"));
+    refl::Value owner_moved = std::move(owner);
+    REQUIRE(*owner_moved.cast<std::unique_ptr<std::string>>() == "owned");
+}
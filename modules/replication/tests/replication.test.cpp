@@ -0,0 +1,160 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+import triple.core;
+import triple.ecs;
+import triple.replication;
+
+using namespace triple;
+
+struct Hitpoints {
+    int value;
+};
+
+struct Spin {
+    float rate;
+};
+
+TEST_CASE("Packets", "[replication]") {
+    using namespace triple::replication;
+    PacketWriter out;
+    out.write_varint(0);
+    out.write_varint(300);
+    out.write_zigzag(-2);
+    out.write(Hitpoints {7});
+    REQUIRE(out.size() == 1 + 2 + 1 + sizeof(Hitpoints));
+
+    PacketReader in(out.bytes());
+    REQUIRE(in.read_varint() == 0);
+    REQUIRE(in.read_varint() == 300);
+    REQUIRE(in.read_zigzag() == -2);
+    Hitpoints hp;
+    in.read(hp);
+    REQUIRE(hp.value == 7);
+    REQUIRE((in.ok() && in.at_end()));
+    in.read_varint();
+    REQUIRE_FALSE(in.ok());
+}
+
+TEST_CASE("Replication", "[replication]") {
+    using namespace triple::replication;
+    auto [server_end, client_end] = LocalTransport::make_pair();
+    ecs::World server;
+    ecs::World client;
+    Replicator replicator(server, server_end);
+    replicator.replicate<core::Transform2D>().replicate<Hitpoints>();
+    Replica replica(client, client_end);
+    replica.replicate<core::Transform2D>().replicate<Hitpoints>();
+
+    std::vector<ecs::Entity> entities;
+    for (int i = 0; i < 100; i++) {
+        entities.push_back(server.spawn(
+            core::Transform2D {.position = {i * 1.5f, -2.25f}, .rotation = 1},
+            Hitpoints {i}
+        ));
+    }
+    // not replicated at all
+    ecs::Entity spinner = server.spawn(Spin {1});
+
+    auto local = [&](ecs::Entity entity) {
+        return replica.local_entity(entity);
+    };
+
+    DeltaStats stats = replicator.send_delta();
+    REQUIRE(stats.m_spawned == 100);
+    REQUIRE(replica.receive() == 1);
+    REQUIRE(replica.entity_count() == 100);
+    REQUIRE_FALSE(local(spinner));
+    for (int i = 0; i < 100; i++) {
+        ecs::Entity e = local(entities[i]);
+        auto& transform = client.get_component<core::Transform2D>(e);
+        REQUIRE(transform.position.x == i * 1.5f);
+        REQUIRE(transform.position.y == -2.25f);
+        REQUIRE(transform.scale.x == 1.0f);
+        REQUIRE(std::abs(transform.rotation - 1.0f) < 1e-4f);
+        REQUIRE(client.get_component<Hitpoints>(e).value == i);
+    }
+
+    SECTION("unchanged worlds send almost nothing") {
+        stats = replicator.send_delta();
+        REQUIRE(stats.m_spawned + stats.m_updated + stats.m_despawned == 0);
+        REQUIRE(stats.m_bytes < 16);
+    }
+
+    SECTION("only changed components are sent") {
+        for (int i = 0; i < 100; i += 10) {
+            server.add_component(entities[i], Hitpoints {-1});
+        }
+        stats = replicator.send_delta();
+        REQUIRE(stats.m_updated == 10);
+        ecs::Tick tick = client.increment_change_tick();
+        replica.receive();
+        // updates show up as changes on the peer too
+        std::size_t changed = 0;
+        for (auto [entity] :
+             client.query<ecs::Entity, ecs::Changed<Hitpoints>>(tick)) {
+            changed++;
+        }
+        REQUIRE(changed == 10);
+        REQUIRE(client.get_component<Hitpoints>(local(entities[20])).value ==
+                -1);
+        REQUIRE(client.get_component<Hitpoints>(local(entities[21])).value ==
+                21);
+    }
+
+    SECTION("spawns, despawns and removed components") {
+        server.despawn(entities[5]);
+        server.remove_component<Hitpoints>(entities[6]);
+        server.remove_component<Hitpoints>(entities[7]);
+        server.remove_component<core::Transform2D>(entities[7]);
+        ecs::Entity late = server.spawn(Hitpoints {99});
+        ecs::Entity ex_spinner = server.spawn(Spin {2});
+        server.add_component(ex_spinner, Hitpoints {1});
+        ecs::Entity gone = local(entities[5]);
+
+        // `late` reuses the slot of entities[5] and replaces it on the peer
+        REQUIRE(late.index == entities[5].index);
+        stats = replicator.send_delta();
+        REQUIRE(stats.m_spawned == 2);
+        REQUIRE(stats.m_updated == 1);
+        REQUIRE(stats.m_despawned == 1);
+        replica.receive();
+        REQUIRE_FALSE(client.has_entity(gone));
+        REQUIRE_FALSE(local(entities[7]));
+        REQUIRE_FALSE(client.has_component<Hitpoints>(local(entities[6])));
+        REQUIRE(client.has_component<core::Transform2D>(local(entities[6])));
+        REQUIRE(client.get_component<Hitpoints>(local(late)).value == 99);
+        REQUIRE(client.get_component<Hitpoints>(local(ex_spinner)).value == 1);
+        REQUIRE_FALSE(client.has_component<Spin>(local(ex_spinner)));
+        REQUIRE(replica.entity_count() == 100);
+    }
+
+    SECTION("malformed and repeated deltas are dropped") {
+        server.add_component(entities[3], Hitpoints {-3});
+        server.despawn(entities[4]);
+        replicator.send_delta();
+        std::vector<std::byte> packet;
+        REQUIRE(client_end.receive(packet));
+        auto hitpoints = [&] {
+            return client.get_component<Hitpoints>(local(entities[3])).value;
+        };
+
+        // cut short after the records, in the despawn list
+        server_end.send({packet.data(), packet.size() - 1});
+        REQUIRE(replica.receive() == 1);
+        REQUIRE(hitpoints() == 3);
+        REQUIRE(replica.entity_count() == 100);
+
+        server_end.send(packet);
+        replica.receive();
+        REQUIRE(hitpoints() == -3);
+        REQUIRE(replica.entity_count() == 99);
+
+        client.get_component<Hitpoints>(local(entities[3])).value = 0;
+        server_end.send(packet);
+        replica.receive();
+        REQUIRE(hitpoints() == 0);
+    }
+}
@@ -0,0 +1,10 @@
+target("triple_replication")
+    set_kind("moduleonly")
+    add_files("*.mpp")
+    add_deps("triple_base", "triple_refl", "triple_ecs", "triple_core")
+
+target("triple_replication-tests")
+    set_kind("binary")
+    add_files("tests/*.test.cpp")
+    add_packages("catch2")
+    add_deps("triple_replication")
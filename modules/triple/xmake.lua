@@ -11,5 +11,6 @@ target("triple")
         "triple_math",
         "triple_refl",
         "triple_render2d",
+        "triple_replication",
         "triple_window"
     )
@@ -10,7 +10,7 @@ struct Text {
 namespace triple::refl {
 template<>
 const Type& type<Text>() {
-    static Type ty("Text", sizeof(Text));
+    static Type ty("Text", sizeof(Text), alignof(Text), type_ops<Text>());
     return ty;
 }
 } // namespace triple::refl
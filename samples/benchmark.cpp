@@ -1,4 +1,14 @@
 #include <catch2/catch_all.hpp>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <random>
+#include <span>
+#include <string>
+#include <thread>
+#include <tuple>
 #include <vector>
 import triple.all;
 
@@ -6,17 +16,17 @@ struct Object {
     int x;
 };
 
+struct Tag {};
+
 constexpr size_t entity_count = 1000000;
+constexpr size_t churn_count = 100000;
 
 TEST_CASE("Benchmark") {
     BENCHMARK_ADVANCED("ecs-system")
     (Catch::Benchmark::Chronometer meter) {
         using namespace triple;
         World world;
-        for (size_t i = 0; i < entity_count; i++) {
-            Entity entity = world.entity();
-            world.add_component(entity, Object {1});
-        }
+        world.spawn_batch(entity_count, Object {1});
         auto query = world.query<Object>();
         meter.measure([&query] {
             size_t result = 0;
@@ -27,26 +37,174 @@ TEST_CASE("Benchmark") {
         });
     };
 
+    BENCHMARK_ADVANCED("ecs-par-for-each")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        world.spawn_batch(entity_count, Object {1});
+        auto query = world.query<Object>();
+        meter.measure([&query] {
+            query.par_for_each([](Object& object) {
+                object.x = object.x * 3 + 1;
+            });
+            return query.matched().size();
+        });
+    };
+
+    // per-run cost of many systems that do almost nothing
+    BENCHMARK_ADVANCED("ecs-system-dispatch")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        world.spawn(Object {1});
+        world.add_resource(Object {0});
+        world.add_schedule(0);
+        for (size_t i = 0; i < 500; i++) {
+            world.add_system(
+                0,
+                +[](Query<const Object> query,
+                    Resource<Object> total,
+                    Commands commands) {
+                    for (auto [object] : query) {
+                        total->x += object.x;
+                    }
+                }
+            );
+        }
+        meter.measure([&world] {
+            world.run_schedule(0);
+            return world.get_resource<Object>()->x;
+        });
+    };
+
+    // a frame of bullets: spawned and despawned through commands
+    BENCHMARK_ADVANCED("ecs-commands")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        Commands commands(world);
+        std::vector<Entity> entities(churn_count);
+        meter.measure([&] {
+            for (Entity& entity : entities) {
+                entity = commands.spawn().add(Object {1}, Tag {}).id();
+            }
+            world.run_commands();
+            for (Entity entity : entities) {
+                commands.entity(entity).despawn();
+            }
+            world.run_commands();
+            return world.entity_count();
+        });
+    };
+
+    // a frame of collision events: sent in one batch, read by one system
+    BENCHMARK_ADVANCED("ecs-events")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        world.add_event<Object>();
+        std::vector<Object> collisions(churn_count, Object {1});
+        auto& writer = world.system([&](EventWriter<Object> writer) {
+            writer.send_batch(collisions);
+        });
+        int sum = 0;
+        auto& reader = world.system([&](EventReader<Object> reader) {
+            for (const Object& event : reader.read()) {
+                sum += event.x;
+            }
+        });
+        meter.measure([&] {
+            world.update_events();
+            writer.run();
+            world.flush_events();
+            reader.run();
+            return sum;
+        });
+    };
+
+    BENCHMARK("ecs-spawn") {
+        using namespace triple;
+        World world;
+        for (size_t i = 0; i < entity_count; i++) {
+            Entity entity = world.entity();
+            world.add_component(entity, Object {1});
+        }
+        return world.entity_count();
+    };
+
+    BENCHMARK("ecs-spawn-batch") {
+        using namespace triple;
+        World world;
+        world.spawn_batch(entity_count, Object {1});
+        return world.entity_count();
+    };
+
     BENCHMARK_ADVANCED("ecs-archetype")
     (Catch::Benchmark::Chronometer meter) {
         using namespace triple;
         Archetype archetype(0, {&type<Object>()});
         Object obj {1};
         for (size_t i = 0; i < entity_count; i++) {
-            archetype.add_entity(i);
-            archetype.set_component(i, type<Object>(), &obj);
+            auto row = archetype.add_entity(
+                Entity {.index = static_cast<u32>(i), .generation = 1}
+            );
+            archetype.set_component(row, type<Object>(), &obj);
         }
         meter.measure([&archetype] {
             size_t result = 0;
-            Object* ptr = (Object*)archetype.get_component(0, type<Object>());
-            for (size_t i = 0; i < entity_count; i++) {
-                result += ptr->x;
-                ptr++;
+            for (size_t chunk = 0; chunk < archetype.chunk_count(); chunk++) {
+                auto* ptr = (Object*)archetype.get_chunk_column(chunk, 0);
+                for (size_t i = 0; i < archetype.chunk_size(chunk); i++) {
+                    result += ptr[i].x;
+                }
+            }
+            return result;
+        });
+    };
+
+    BENCHMARK_ADVANCED("ecs-random-access")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        std::vector<Entity> entities;
+        entities.reserve(entity_count);
+        for (size_t i = 0; i < entity_count; i++) {
+            Entity entity = world.entity();
+            world.add_component(entity, Object {1});
+            entities.push_back(entity);
+        }
+        std::shuffle(entities.begin(), entities.end(), std::mt19937 {42});
+        meter.measure([&world, &entities] {
+            size_t result = 0;
+            for (Entity entity : entities) {
+                result += world.get_component<Object>(entity).x;
             }
             return result;
         });
     };
 
+    BENCHMARK_ADVANCED("ecs-add-remove")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        World world;
+        std::vector<Entity> entities;
+        entities.reserve(churn_count);
+        for (size_t i = 0; i < churn_count; i++) {
+            Entity entity = world.entity();
+            world.add_component(entity, Object {1});
+            entities.push_back(entity);
+        }
+        meter.measure([&world, &entities] {
+            for (Entity entity : entities) {
+                world.add_component(entity, Tag {});
+            }
+            for (Entity entity : entities) {
+                world.remove_component<Tag>(entity);
+            }
+            return entities.size();
+        });
+    };
+
     BENCHMARK_ADVANCED("vector-pointer")
     (Catch::Benchmark::Chronometer meter) {
         std::vector<Object*> objs;
@@ -80,6 +238,252 @@ TEST_CASE("Benchmark") {
     };
 }
 
+TEST_CASE("Value benchmark") {
+    using namespace triple;
+    constexpr size_t value_count = 10000;
+    // fits inline, and a resource-sized one that doesn't
+    struct Large {
+        float data[16];
+    };
+
+    BENCHMARK_ADVANCED("refl-value-construct")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<refl::Value> values(value_count);
+        meter.measure([&values] {
+            for (size_t i = 0; i < values.size(); i++) {
+                values[i] = refl::Value(Object {static_cast<int>(i)});
+            }
+            return values.size();
+        });
+    };
+
+    BENCHMARK_ADVANCED("refl-value-copy")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<refl::Value> values(value_count, refl::Value(Object {1}));
+        std::vector<refl::Value> copies(value_count);
+        meter.measure([&] {
+            for (size_t i = 0; i < values.size(); i++) {
+                copies[i] = values[i];
+            }
+            return copies.size();
+        });
+    };
+
+    BENCHMARK_ADVANCED("refl-value-move")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<refl::Value> values(value_count, refl::Value(Object {1}));
+        std::vector<refl::Value> moved(value_count);
+        meter.measure([&] {
+            for (size_t i = 0; i < values.size(); i++) {
+                moved[i] = std::move(values[i]);
+                values[i] = std::move(moved[i]);
+            }
+            return values.size();
+        });
+    };
+
+    BENCHMARK_ADVANCED("refl-value-copy-large")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<refl::Value> values(value_count, refl::Value(Large {}));
+        std::vector<refl::Value> copies(value_count);
+        meter.measure([&] {
+            for (size_t i = 0; i < values.size(); i++) {
+                copies[i] = values[i];
+            }
+            return copies.size();
+        });
+    };
+}
+
+TEST_CASE("Snapshot benchmark") {
+    using namespace triple;
+    auto path = std::filesystem::temp_directory_path() / "triple-bench.bin";
+    World source;
+    source.spawn_batch(entity_count, Object {1}, math::Vector2 {1, 2});
+    source.spawn_batch(entity_count / 10, Object {2});
+
+    BENCHMARK("ecs-snapshot-save") {
+        return source.save_snapshot(path);
+    };
+
+    BENCHMARK_ADVANCED("ecs-snapshot-load")
+    (Catch::Benchmark::Chronometer meter) {
+        // loading needs an empty world each run
+        std::vector<std::unique_ptr<World>> worlds(meter.runs());
+        for (auto& world : worlds) {
+            world = std::make_unique<World>();
+        }
+        meter.measure([&](int i) { return worlds[i]->load_snapshot(path); });
+    };
+
+    std::filesystem::remove(path);
+}
+
+// Drops packets, so only encoding is measured.
+struct NullTransport : triple::Transport {
+    void send(std::span<const std::byte>) override {}
+    bool receive(std::vector<std::byte>&) override { return false; }
+};
+
+TEST_CASE("Replication benchmark") {
+    using namespace triple;
+    constexpr size_t replicated_count = 10000;
+    World world;
+    world.spawn_batch(replicated_count, [](size_t i) {
+        return std::tuple {
+            Transform2D {.position = {float(i % 100), float(i / 100)}},
+            Object {int(i)},
+        };
+    });
+    NullTransport transport;
+    Replicator replicator(world, transport);
+    replicator.replicate<Transform2D>().replicate<Object>();
+    replicator.send_delta();
+
+    BENCHMARK("replication-delta-idle") {
+        return replicator.send_delta().m_bytes;
+    };
+
+    BENCHMARK_ADVANCED("replication-delta-moving")
+    (Catch::Benchmark::Chronometer meter) {
+        meter.measure([&] {
+            for (auto [transform] : world.query<Transform2D>()) {
+                transform.position.x += 0.5f;
+            }
+            return replicator.send_delta().m_bytes;
+        });
+    };
+
+    BENCHMARK_ADVANCED("replication-delta-full")
+    (Catch::Benchmark::Chronometer meter) {
+        meter.measure([&] {
+            Replicator fresh(world, transport);
+            fresh.replicate<Transform2D>().replicate<Object>();
+            return fresh.send_delta().m_bytes;
+        });
+    };
+}
+
+TEST_CASE("Transform benchmark") {
+    using namespace triple;
+    constexpr size_t transform_count = 10000;
+    std::vector<Transform2D> transforms(transform_count);
+    for (size_t i = 0; i < transform_count; i++) {
+        transforms[i].position = {float(i % 100), float(i / 100)};
+        transforms[i].rotation = float(i) * 0.01f;
+    }
+
+    // what model_matrix() used to do
+    BENCHMARK_ADVANCED("transform-matrix4x4")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<Matrix4x4> out(transform_count);
+        meter.measure([&] {
+            for (size_t i = 0; i < transform_count; i++) {
+                const Transform2D& t = transforms[i];
+                out[i] = translate(t.position.x, t.position.y, 0.0f) *
+                         rotate_z(t.rotation) * scale(t.scale.x, t.scale.y, 1);
+            }
+            return out[0][0][0];
+        });
+    };
+
+    BENCHMARK_ADVANCED("transform-affine")
+    (Catch::Benchmark::Chronometer meter) {
+        std::vector<Affine2D> out(transform_count);
+        meter.measure([&] {
+            for (size_t i = 0; i < transform_count; i++) {
+                out[i] = transforms[i].affine();
+            }
+            return out[0][0][0];
+        });
+    };
+
+    // 1000 roots with 9 children each, every root moving
+    BENCHMARK_ADVANCED("transform-propagate")
+    (Catch::Benchmark::Chronometer meter) {
+        App app;
+        app.add_plugin<TransformPlugin>();
+        World& world = app.world();
+        for (size_t i = 0; i < transform_count / 10; i++) {
+            Entity root = world.spawn(transforms[i * 10]);
+            for (size_t j = 1; j < 10; j++) {
+                set_parent(world, world.spawn(transforms[i * 10 + j]), root);
+            }
+        }
+        app.run_schedule(PostUpdate);
+        meter.measure([&] {
+            auto roots = world.query<Transform2D, Without<Parent>>();
+            for (auto [transform] : roots) {
+                transform.position.x += 0.5f;
+            }
+            app.run_schedule(PostUpdate);
+        });
+    };
+}
+
+TEST_CASE("Thread pool benchmark") {
+    constexpr size_t task_count = 10000;
+
+    // cost of queueing and running empty tasks from outside the pool
+    BENCHMARK_ADVANCED("tasks-spawn")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        ThreadPool& pool = ThreadPool::shared();
+        meter.measure([&pool] {
+            TaskGroup group(pool);
+            for (size_t i = 0; i < task_count; i++) {
+                group.run([] {});
+            }
+            group.wait();
+            return pool.thread_count();
+        });
+    };
+
+    // tasks spawned from a worker land in its own deque, the others steal
+    BENCHMARK_ADVANCED("tasks-steal")
+    (Catch::Benchmark::Chronometer meter) {
+        using namespace triple;
+        ThreadPool& pool = ThreadPool::shared();
+        meter.measure([&pool] {
+            std::function<void(size_t)> split = [&](size_t count) {
+                if (count <= 1) {
+                    return;
+                }
+                TaskGroup group(pool);
+                group.run([&split, count] { split(count / 2); });
+                group.run([&split, count] { split(count - count / 2); });
+                group.wait();
+            };
+            split(task_count);
+            return task_count;
+        });
+    };
+
+    // the same parallel_for on 1 to N threads
+    for (size_t threads = 1; threads <= std::thread::hardware_concurrency();
+         threads *= 2) {
+        BENCHMARK_ADVANCED("tasks-scaling-" + std::to_string(threads))
+        (Catch::Benchmark::Chronometer meter) {
+            using namespace triple;
+            ThreadPool pool(threads);
+            std::vector<float> values(entity_count, 1.0f);
+            meter.measure([&pool, &values] {
+                pool.parallel_for(
+                    0,
+                    values.size(),
+                    4096,
+                    [&values](size_t first, size_t last) {
+                        for (size_t i = first; i < last; i++) {
+                            values[i] = std::sqrt(values[i] * 3.0f + 1.0f);
+                        }
+                    }
+                );
+                return values[0];
+            });
+        };
+    }
+}
+
 // using namespace triple;
 // void benchmark(Query<Object>& query) {
 //     for (int i = 0; i < 1000; i++) {
@@ -1,6 +1,7 @@
 #include "imgui.h"
 
 #include <cassert>
+#include <cmath>
 #include <filesystem>
 #include <unordered_set>
 
@@ -28,12 +29,19 @@ bool paused = false;
 struct BoxCollider {
     Vector2 size;
     Vector2 offset;
-    inline Rect rect_global(const Transform2D& transform) const {
-        auto center = transform.position;
-        auto size_scaled = size * transform.scale;
+    // Bounds of the transformed box, from the cached global transform.
+    inline Rect rect_global(const GlobalTransform2D& transform) const {
+        const Affine2D& affine = transform.affine;
+        auto center = affine.translation() + offset;
+        Vector2 x_axis = affine.transform_vector({size.x / 2.0f, 0.0f});
+        Vector2 y_axis = affine.transform_vector({0.0f, size.y / 2.0f});
+        Vector2 half_size {
+            std::abs(x_axis.x) + std::abs(y_axis.x),
+            std::abs(x_axis.y) + std::abs(y_axis.y),
+        };
         return Rect {
-            .min = center + offset - size_scaled / 2.0f,
-            .max = center + offset + size_scaled / 2.0f,
+            .min = center - half_size,
+            .max = center + half_size,
         };
     }
 };
@@ -52,9 +60,12 @@ struct Enemy {
 
 struct Bullet {
     Vector2 speed;
-    enum Tag { Player, Enemy } tag;
 };
 
+// Marks who fired a bullet.
+struct PlayerBullet {};
+struct EnemyBullet {};
+
 struct Game {
     Timer enemy_spawn_timer;
     int score;
@@ -89,34 +100,40 @@ bool rect_collide(const Rect& a, const Rect& b) {
 }
 
 void check_bullet_collide(
-    Query<Bullet, BoxCollider, Transform2D> q_bullet,
-    Query<Enemy, BoxCollider, Transform2D> q_enemy,
-    Query<Player, BoxCollider, Transform2D> q_player,
+    Query<
+        Entity,
+        const BoxCollider,
+        const GlobalTransform2D,
+        With<EnemyBullet>> q_enemy_bullet,
+    Query<
+        Entity,
+        const BoxCollider,
+        const GlobalTransform2D,
+        With<PlayerBullet>> q_player_bullet,
+    Query<Enemy, const BoxCollider, const GlobalTransform2D> q_enemy,
+    Query<Player, const BoxCollider, const GlobalTransform2D> q_player,
     Commands commands
 ) {
+    // the player has no global transform until the end of its first frame
+    if (q_player.empty()) {
+        return;
+    }
     std::unordered_set<Entity> to_despawn;
     auto [player, collider_player, transform_player] = *q_player.begin();
-    for (auto iter1 = q_bullet.begin(); iter1 != q_bullet.end(); ++iter1) {
-        if (to_despawn.find(iter1.entity()) != to_despawn.end())
-            continue;
-        auto [bullet, collider_bullet, transform_bullet] = *iter1;
+    auto rect_player = collider_player.rect_global(transform_player);
+    for (auto [bullet, collider_bullet, transform_bullet] : q_enemy_bullet) {
         auto rect_bullet = collider_bullet.rect_global(transform_bullet);
-        auto rect_player = collider_player.rect_global(transform_player);
-        if (bullet.tag == Bullet::Enemy &&
-            rect_collide(rect_bullet, rect_player)) {
-            to_despawn.insert(iter1.entity());
+        if (rect_collide(rect_bullet, rect_player)) {
+            to_despawn.insert(bullet);
             player.health--;
-            continue;
         }
-        for (auto iter2 = q_enemy.begin(); iter2 != q_enemy.end(); ++iter2) {
-            if (to_despawn.find(iter2.entity()) != to_despawn.end())
-                continue;
-            auto [enemy, collider_enemy, transform_enemy] = *iter2;
-            if (bullet.tag == Bullet::Enemy)
-                continue;
+    }
+    for (auto [bullet, collider_bullet, transform_bullet] : q_player_bullet) {
+        auto rect_bullet = collider_bullet.rect_global(transform_bullet);
+        for (auto [enemy, collider_enemy, transform_enemy] : q_enemy) {
             auto rect_enemy = collider_enemy.rect_global(transform_enemy);
             if (rect_collide(rect_bullet, rect_enemy)) {
-                to_despawn.insert(iter1.entity());
+                to_despawn.insert(bullet);
                 enemy.health--;
             }
         }
@@ -172,7 +189,7 @@ void setup_scene(
 }
 
 void draw_debug(
-    Query<BoxCollider, Transform2D> q_player,
+    Query<const BoxCollider, const GlobalTransform2D> q_player,
     Resource<Debug> debug
 ) {
     if (!show_debug)
@@ -184,8 +201,8 @@ void draw_debug(
 
 void move_player(
     Query<Player, Transform2D> q_player,
-    Resource<KeyInput> key_input,
-    Resource<Time> time
+    Resource<const KeyInput> key_input,
+    Resource<const Time> time
 ) {
     for (auto iter = q_player.begin(); iter != q_player.end(); ++iter) {
         auto [player, transform] = *iter;
@@ -210,8 +227,8 @@ void player_shoot(
     Query<Player, Transform2D> q_player,
     Commands commands,
     Resource<AssetServer> asset_server,
-    Resource<Time> time,
-    Resource<KeyInput> key_input
+    Resource<const Time> time,
+    Resource<const KeyInput> key_input
 ) {
     auto [player, transform] = *q_player.begin();
     player.shoot_timer.tick(time->delta());
@@ -219,8 +236,8 @@ void player_shoot(
         commands.spawn().add(
             Bullet {
                 .speed = {0.0f, player_bullet_speed},
-                .tag = Bullet::Player,
             },
+            PlayerBullet {},
             Sprite {
                 .texture = asset_server->load<Texture2D>("bullet_2.png"),
             },
@@ -238,7 +255,7 @@ void player_shoot(
 
 void update_bullet(
     Query<Bullet, Transform2D> q_bullet,
-    Resource<Time> time,
+    Resource<const Time> time,
     Resource<Window> win,
     Commands commands
 ) {
@@ -256,7 +273,7 @@ void update_bullet(
 void spawn_enemy(
     Commands commands,
     Resource<AssetServer> asset_server,
-    Resource<Time> time,
+    Resource<const Time> time,
     Resource<Game> game,
     Resource<Window> win
 ) {
@@ -290,21 +307,32 @@ void spawn_enemy(
 void update_enemy(
     Commands commands,
     Resource<AssetServer> asset_server,
-    Query<Entity, Enemy, Transform2D, BoxCollider> q_enemy,
-    Query<Player, Transform2D, BoxCollider> q_player,
-    Resource<Time> time,
+    Query<
+        Entity,
+        Enemy,
+        Transform2D,
+        Optional<const GlobalTransform2D>,
+        const BoxCollider> q_enemy,
+    Query<Player, const GlobalTransform2D, const BoxCollider> q_player,
+    Resource<const Time> time,
     Resource<Window> win,
     Resource<Game> game
 ) {
+    if (q_player.empty()) {
+        return;
+    }
     auto [player, transform_player, collider_player] = *q_player.begin();
-    for (auto [enemy_entity, enemy, transform, collider] : q_enemy) {
+    for (auto [enemy_entity, enemy, transform, global, collider] : q_enemy) {
         if (enemy.health <= 0) {
             commands.entity(enemy_entity).despawn();
             game->score++;
             continue;
         }
-        if (rect_collide(
-                collider.rect_global(transform),
+        // global transforms are cached from the previous frame, new
+        // enemies get theirs at its end
+        if (global != nullptr &&
+            rect_collide(
+                collider.rect_global(*global),
                 collider_player.rect_global(transform_player)
             )) {
             commands.entity(enemy_entity).despawn();
@@ -321,8 +349,8 @@ void update_enemy(
             commands.spawn().add(
                 Bullet {
                     .speed = {0.0f, -enemy_bullet_speed},
-                    .tag = Bullet::Enemy,
                 },
+                EnemyBullet {},
                 Sprite {
                     .texture = asset_server->load<Texture2D>("bullet_0.png"),
                 },
@@ -460,6 +488,7 @@ int main() {
             .enemy_spawn_timer = {enemy_spawn_cooldown, TimerMode::Repeating},
             .score = 0
         })
+        .set_executor(Update, Executor::Parallel)
         .add_system(StartUp, setup_scene)
         .add_system(Update, check_bullet_collide)
         .add_system(Update, draw_debug)